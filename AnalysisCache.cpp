@@ -0,0 +1,193 @@
+#include "AnalysisCache.h"
+#include <boost/filesystem/operations.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace ac {
+
+struct AnalysisCache::Header {
+	std::array<char, 8u> magic;
+	std::uint32_t version;
+	std::uint32_t entry_size;
+	std::uint64_t capacity;
+};
+
+struct AnalysisCache::Entry {
+	std::uint64_t key;
+	std::int32_t score;
+	std::uint16_t best_move;
+	std::uint16_t ponder_move;
+	// Zero for a never-written slot.
+	std::uint8_t occupied;
+	// 0 = no score, 1 = centipawns, 2 = mate.
+	std::uint8_t score_kind;
+	std::uint8_t depth;
+	std::uint8_t pv_length;
+	std::array<std::uint16_t, max_pv_length> pv;
+};
+
+static_assert(std::is_trivially_copyable_v<AnalysisCache::Header>);
+static_assert(std::is_trivially_copyable_v<AnalysisCache::Entry>);
+
+static constexpr std::array<char, 8u> analysis_cache_magic = {'A', 'C', 'C', 'A', 'C', 'H', 'E', '\0'};
+static constexpr std::uint32_t analysis_cache_version = 1u;
+
+static std::size_t round_up_to_power_of_two(std::size_t n) {
+	std::size_t result = 1u;
+	while(result < n) {
+		result <<= 1u;
+	}
+	return result;
+}
+
+static void create_cache_file(const bfs::path& path, std::size_t capacity) {
+	AnalysisCache::Header header{
+		analysis_cache_magic,
+		analysis_cache_version,
+		static_cast<std::uint32_t>(sizeof(AnalysisCache::Entry)),
+		static_cast<std::uint64_t>(capacity)
+	};
+	{
+		std::ofstream out(path.string(), std::ios::binary | std::ios::trunc);
+		if(not out) {
+			throw std::runtime_error(fmt::format("Failed to create analysis cache '{}'.", path.string()));
+		}
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	}
+	// Extending the file zero-fills it, which marks every entry as unoccupied.
+	bfs::resize_file(path, sizeof(AnalysisCache::Header) + capacity * sizeof(AnalysisCache::Entry));
+}
+
+static bfs::path prepare_cache_file(const bfs::path& path, std::size_t capacity) {
+	if(not bfs::exists(path)) {
+		create_cache_file(path, round_up_to_power_of_two(std::max(capacity, AnalysisCache::probe_length)));
+	}
+	return path;
+}
+
+AnalysisCache::AnalysisCache(const bfs::path& path, std::size_t capacity):
+	file_(prepare_cache_file(path, capacity).string().c_str(), bip::read_write),
+	region_(file_, bip::read_write),
+	mutex_()
+{
+	if(region_.get_size() < sizeof(Header)) {
+		throw std::runtime_error(fmt::format("Analysis cache '{}' is truncated.", path.string()));
+	}
+	const auto& hdr = header();
+	if(hdr.magic != analysis_cache_magic or hdr.version != analysis_cache_version) {
+		throw std::runtime_error(fmt::format("'{}' is not an analysis cache file.", path.string()));
+	}
+	if(hdr.entry_size != sizeof(Entry)) {
+		throw std::runtime_error(fmt::format(
+			"Analysis cache '{}' has entries of size {} (expected {}).",
+			path.string(),
+			hdr.entry_size,
+			sizeof(Entry)
+		));
+	}
+	if(region_.get_size() < sizeof(Header) + hdr.capacity * sizeof(Entry)) {
+		throw std::runtime_error(fmt::format("Analysis cache '{}' is truncated.", path.string()));
+	}
+	if(hdr.capacity == 0u or (hdr.capacity & (hdr.capacity - 1u)) != 0u) {
+		throw std::runtime_error(fmt::format("Analysis cache '{}' has a corrupt header.", path.string()));
+	}
+}
+
+std::size_t AnalysisCache::capacity() const {
+	return header().capacity;
+}
+
+const AnalysisCache::Header& AnalysisCache::header() const {
+	return *static_cast<const Header*>(region_.get_address());
+}
+
+const AnalysisCache::Entry* AnalysisCache::entries() const {
+	return reinterpret_cast<const Entry*>(static_cast<const char*>(region_.get_address()) + sizeof(Header));
+}
+
+AnalysisCache::Entry* AnalysisCache::entries() {
+	return const_cast<Entry*>(std::as_const(*this).entries());
+}
+
+std::optional<SearchResult> AnalysisCache::find(std::uint64_t key, std::size_t min_depth) const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto mask = capacity() - 1u;
+	const auto* table = entries();
+	for(std::size_t i = 0u; i < probe_length; ++i) {
+		const auto& entry = table[(key + i) & mask];
+		if(not entry.occupied) {
+			return std::nullopt;
+		}
+		if(entry.key != key) {
+			continue;
+		}
+		if(entry.depth < min_depth) {
+			return std::nullopt;
+		}
+		SearchResult result;
+		if(entry.best_move != 0u) {
+			result.best_move = PackedMove::from_bits(entry.best_move);
+		}
+		if(entry.ponder_move != 0u) {
+			result.ponder_move = PackedMove::from_bits(entry.ponder_move);
+		}
+		if(entry.score_kind != 0u) {
+			auto kind = entry.score_kind == 1u ? uci::ScoreKind::Centipawns : uci::ScoreKind::Mate;
+			result.score = uci::Score{kind, entry.score};
+		}
+		result.depth = entry.depth;
+		result.pv.reserve(entry.pv_length);
+		for(std::size_t j = 0u; j < entry.pv_length; ++j) {
+			result.pv.push_back(PackedMove::from_bits(entry.pv[j]));
+		}
+		return result;
+	}
+	return std::nullopt;
+}
+
+void AnalysisCache::insert(std::uint64_t key, const SearchResult& result) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto mask = capacity() - 1u;
+	auto* table = entries();
+	Entry* slot = nullptr;
+	for(std::size_t i = 0u; i < probe_length; ++i) {
+		auto& entry = table[(key + i) & mask];
+		if(not entry.occupied or entry.key == key) {
+			slot = &entry;
+			break;
+		}
+		if(not slot or entry.depth < slot->depth) {
+			slot = &entry;
+		}
+	}
+	assert(slot);
+	if(slot->occupied and slot->key == key and slot->depth > result.depth) {
+		return;
+	}
+	Entry entry{};
+	entry.key = key;
+	entry.occupied = 1u;
+	entry.best_move = result.best_move ? result.best_move->bits() : 0u;
+	entry.ponder_move = result.ponder_move ? result.ponder_move->bits() : 0u;
+	if(result.score) {
+		entry.score_kind = result.score->kind == uci::ScoreKind::Centipawns ? 1u : 2u;
+		entry.score = result.score->value;
+	}
+	entry.depth = static_cast<std::uint8_t>(std::min<std::size_t>(result.depth, 0xFFu));
+	entry.pv_length = static_cast<std::uint8_t>(std::min(result.pv.size(), max_pv_length));
+	for(std::size_t j = 0u; j < entry.pv_length; ++j) {
+		entry.pv[j] = result.pv[j].bits();
+	}
+	std::memcpy(slot, &entry, sizeof(entry));
+}
+
+void AnalysisCache::flush() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	region_.flush();
+}
+
+} /* namespace ac */
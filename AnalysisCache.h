@@ -0,0 +1,62 @@
+#ifndef AC_ANALYSIS_CACHE_H
+#define AC_ANALYSIS_CACHE_H
+
+#include "SearchResult.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem/path.hpp>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace ac {
+
+namespace bip = boost::interprocess;
+namespace bfs = boost::filesystem;
+
+// Persistent table of engine results keyed by position hash.  The table lives in a
+// memory-mapped file of fixed capacity that uses open addressing with a short linear probe;
+// when every slot in the probe window is taken, the shallowest result is evicted.
+//
+// The file is written in the host's byte order and is not meant to be shared across
+// architectures.
+struct AnalysisCache {
+	static constexpr std::size_t default_capacity = std::size_t(1u) << 20u;
+	static constexpr std::size_t max_pv_length    = 16u;
+	static constexpr std::size_t probe_length     = 8u;
+
+	// On-disk layout, defined in AnalysisCache.cpp.
+	struct Header;
+	struct Entry;
+
+	// Open the cache stored at 'path', creating it with room for at least 'capacity'
+	// entries if it does not exist yet.  The capacity of an existing file is kept.
+	AnalysisCache(const bfs::path& path, std::size_t capacity = default_capacity);
+
+	AnalysisCache(const AnalysisCache&) = delete;
+	AnalysisCache& operator=(const AnalysisCache&) = delete;
+
+	// Return the stored result for 'key' if it was searched to at least 'min_depth'.
+	std::optional<SearchResult> find(std::uint64_t key, std::size_t min_depth) const;
+
+	// Store 'result' for 'key', unless a deeper result for the same key is already present.
+	void insert(std::uint64_t key, const SearchResult& result);
+
+	std::size_t capacity() const;
+
+	// Write dirty pages back to the file.
+	void flush();
+
+private:
+	const Header& header() const;
+	const Entry* entries() const;
+	Entry* entries();
+
+	bip::file_mapping file_;
+	bip::mapped_region region_;
+	mutable std::mutex mutex_;
+};
+
+} /* namespace ac */
+
+#endif /* AC_ANALYSIS_CACHE_H */
@@ -0,0 +1,100 @@
+#include "AnalysisCoalescer.h"
+#include "Zobrist.h"
+#include <algorithm>
+
+namespace ac {
+
+AnalysisCoalescer::AnalysisCoalescer(dispatch_function dispatch):
+	dispatch_(std::move(dispatch)),
+	mutex_(),
+	flights_()
+{
+	assert(dispatch_);
+}
+
+std::size_t AnalysisCoalescer::in_flight() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return flights_.size();
+}
+
+void AnalysisCoalescer::broadcast(Flight& flight, const uci::InfoLine& info) {
+	// Listeners are called with the flight locked so that a caller joining mid-search sees
+	// its replayed lines strictly before any newer ones.
+	std::lock_guard<std::mutex> lock(flight.mutex);
+	auto idx = uci::pv_index(info);
+	if(not idx) {
+		return;
+	}
+	if(not info.pv.empty()) {
+		if(flight.latest.size() <= *idx) {
+			flight.latest.resize(*idx + 1u);
+		}
+		flight.latest[*idx] = info;
+	}
+	// One caller's failing callback mustn't abort the search everyone else is waiting on; it
+	// just stops receiving lines.
+	auto& listeners = flight.listeners;
+	listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [&](const info_callback& listener) {
+		try {
+			listener(info);
+			return false;
+		} catch(...) {
+			return true;
+		}
+	}), listeners.end());
+}
+
+SearchResult AnalysisCoalescer::analyze(const GameSnapshot& position, const UCIGoArgs& args, info_callback on_info) {
+	if(args.ponder) {
+		return dispatch_(position, args, on_info);
+	}
+	Key key{zobrist_hash(position), go_command(args)};
+	if(args.multipv) {
+		key.command += fmt::format(" multipv {}", *args.multipv);
+	}
+	std::shared_ptr<Flight> flight;
+	std::promise<SearchResult> promise;
+	bool leader = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto pos = flights_.find(key);
+		if(pos == flights_.end()) {
+			flight = std::make_shared<Flight>();
+			flight->result = promise.get_future().share();
+			flights_.emplace(key, flight);
+			leader = true;
+		} else {
+			flight = pos->second;
+		}
+	}
+	if(on_info) {
+		std::lock_guard<std::mutex> lock(flight->mutex);
+		for(const auto& info: flight->latest) {
+			if(not info.pv.empty()) {
+				on_info(info);
+			}
+		}
+		flight->listeners.push_back(std::move(on_info));
+	}
+	if(not leader) {
+		return flight->result.get();
+	}
+	auto finish = [&]() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		flights_.erase(key);
+	};
+	try {
+		auto result = dispatch_(position, args, [&](const uci::InfoLine& info) {
+			broadcast(*flight, info);
+		});
+		finish();
+		promise.set_value(result);
+		return result;
+	} catch(...) {
+		finish();
+		promise.set_exception(std::current_exception());
+		throw;
+	}
+}
+
+} /* namespace ac */
@@ -0,0 +1,74 @@
+#ifndef AC_ANALYSIS_COALESCER_H
+#define AC_ANALYSIS_COALESCER_H
+
+#include "ChessEngine.h"
+#include "GameSnapshot.h"
+#include "SearchResult.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ac {
+
+// Sits in front of engine dispatch and merges identical analysis requests.  A request is
+// identical to an in-flight one if the position hash, the rendered 'go' command and the
+// MultiPV setting match; later callers attach to the running search, receive its remaining
+// 'info' lines (plus the latest line for each PV already seen) and share its result.
+struct AnalysisCoalescer {
+	using info_callback = ChessEngine::info_callback;
+	using dispatch_function = std::function<
+		SearchResult(const GameSnapshot&, const UCIGoArgs&, const info_callback&)
+	>;
+
+	explicit AnalysisCoalescer(dispatch_function dispatch);
+
+	AnalysisCoalescer(const AnalysisCoalescer&) = delete;
+	AnalysisCoalescer& operator=(const AnalysisCoalescer&) = delete;
+
+	// Analyze 'position', or join an identical analysis already running.  Blocks until the
+	// search finishes.  Pondering searches are never coalesced.  If 'on_info' throws, it
+	// is called no more and the exception is swallowed; the search carries on for the
+	// other callers.
+	SearchResult analyze(const GameSnapshot& position, const UCIGoArgs& args, info_callback on_info = info_callback());
+
+	// Number of distinct searches currently running.
+	std::size_t in_flight() const;
+
+private:
+	struct Key {
+		std::uint64_t position_hash;
+		std::string command;
+
+		friend bool operator==(const Key& l, const Key& r) {
+			return l.position_hash == r.position_hash and l.command == r.command;
+		}
+	};
+
+	struct KeyHash {
+		std::size_t operator()(const Key& key) const {
+			return static_cast<std::size_t>(key.position_hash) ^ std::hash<std::string>{}(key.command);
+		}
+	};
+
+	struct Flight {
+		std::mutex mutex;
+		std::vector<info_callback> listeners;
+		// Most recent line for each PV, replayed to callers that join late.
+		std::vector<uci::InfoLine> latest;
+		std::shared_future<SearchResult> result;
+	};
+
+	void broadcast(Flight& flight, const uci::InfoLine& info);
+
+	dispatch_function dispatch_;
+	mutable std::mutex mutex_;
+	std::unordered_map<Key, std::shared_ptr<Flight>, KeyHash> flights_;
+};
+
+} /* namespace ac */
+
+#endif /* AC_ANALYSIS_COALESCER_H */
@@ -59,6 +59,15 @@ public:
 
 	BitBoard() = default;
 
+	// Bit 'index(pos)' is set for each position 'pos' in the set.
+	static constexpr BitBoard from_bits(std::uint64_t bits) {
+		return BitBoard(bits);
+	}
+
+	constexpr std::uint64_t bits() const {
+		return board_;
+	}
+
 	constexpr bool operator[](BoardPos pos) const {
 		return (0x01u & (board_ >> index(pos))) == 1u;
 	}
@@ -247,6 +247,19 @@ struct Board {
 		return (*this)[pos];
 	}
 
+	// Place 'piece' on the empty position 'pos'.  Unlike assigning through operator[], this
+	// touches a single bit board.
+	constexpr void put_piece(ChessPiece piece, BoardPos pos) {
+		assert(not std::as_const(*this)[pos]);
+		bit_boards_[index(piece)][pos] = true;
+	}
+
+	// Take 'piece', which must be standing on 'pos', off the board.
+	constexpr void remove_piece(ChessPiece piece, BoardPos pos) {
+		assert(std::as_const(*this)[pos] == piece);
+		bit_boards_[index(piece)][pos] = false;
+	}
+
 	constexpr std::optional<ChessPiece> piece_at(std::pair<BoardRow, BoardCol> pos) const {
 		return (*this)[pos];
 	}
@@ -709,16 +722,16 @@ struct CompressedBoard {
 	}
 
 private:
-	// Each byte encodes 2 adjacent positions 
+	// Each byte encodes 2 adjacent positions; 0xCC is two 'OptionalChessPiece::None's.
 	std::array<std::array<unsigned char, 4u>, 8u> board_ = {
-		std::array<unsigned char, 4u>{0u, 0u, 0u, 0u}, 
-		std::array<unsigned char, 4u>{0u, 0u, 0u, 0u}, 
-		std::array<unsigned char, 4u>{0u, 0u, 0u, 0u}, 
-		std::array<unsigned char, 4u>{0u, 0u, 0u, 0u}, 
-		std::array<unsigned char, 4u>{0u, 0u, 0u, 0u}, 
-		std::array<unsigned char, 4u>{0u, 0u, 0u, 0u}, 
-		std::array<unsigned char, 4u>{0u, 0u, 0u, 0u}, 
-		std::array<unsigned char, 4u>{0u, 0u, 0u, 0u}
+		std::array<unsigned char, 4u>{0xCCu, 0xCCu, 0xCCu, 0xCCu}, 
+		std::array<unsigned char, 4u>{0xCCu, 0xCCu, 0xCCu, 0xCCu}, 
+		std::array<unsigned char, 4u>{0xCCu, 0xCCu, 0xCCu, 0xCCu}, 
+		std::array<unsigned char, 4u>{0xCCu, 0xCCu, 0xCCu, 0xCCu}, 
+		std::array<unsigned char, 4u>{0xCCu, 0xCCu, 0xCCu, 0xCCu}, 
+		std::array<unsigned char, 4u>{0xCCu, 0xCCu, 0xCCu, 0xCCu}, 
+		std::array<unsigned char, 4u>{0xCCu, 0xCCu, 0xCCu, 0xCCu}, 
+		std::array<unsigned char, 4u>{0xCCu, 0xCCu, 0xCCu, 0xCCu}
 	};
 };
 
@@ -1,5 +1,6 @@
 #include "ChessEngine.h"
 #include "uci_parsers.h"
+#include "Zobrist.h"
 
 namespace ac {
 
@@ -24,6 +25,14 @@ ChessEngine::ChessEngine(const char* path):
 	parse_uci_options();
 }
 
+ChessEngine::~ChessEngine() {
+	try {
+		stop_pondering();
+	} catch(...) {
+		// The engine is gone or its pipe is broken; there's no search left to wait for.
+	}
+}
+
 const ChessEngine::option_map_type& ChessEngine::options() const {
 	return options_;
 }
@@ -143,6 +152,64 @@ void ChessEngine::send_command(std::string_view s) {
 	}
 	assert(not s.empty());
 	engine_input_ << s << std::endl;
+	if(std::atomic_load(&latency_)) {
+		record_sent(s);
+	}
+}
+
+void ChessEngine::record_sent(std::string_view command) {
+	auto now = clock_type::now().time_since_epoch().count();
+	auto is = [&](std::string_view name) {
+		return command.substr(0u, name.size()) == name
+			and (command.size() == name.size() or command[name.size()] == ' ');
+	};
+	if(is("go")) {
+		go_sent_ = now;
+		stop_sent_ = 0;
+		ponderhit_sent_ = 0;
+		awaiting_first_info_ = true;
+	} else if(is("isready")) {
+		isready_sent_ = now;
+	} else if(is("stop")) {
+		stop_sent_ = now;
+	} else if(is("ponderhit")) {
+		ponderhit_sent_ = now;
+	}
+}
+
+void ChessEngine::record_since(LatencyHistogram& hist, const std::atomic<clock_type::rep>& sent, clock_type::time_point received) {
+	auto sent_ticks = sent.load();
+	if(sent_ticks == 0) {
+		return;
+	}
+	hist.record(received - clock_type::time_point(clock_type::duration(sent_ticks)));
+}
+
+void ChessEngine::set_latency_stats(std::shared_ptr<EngineLatencyStats> stats) {
+	// The ponder thread may be reading 'latency_' concurrently.
+	std::atomic_store(&latency_, std::move(stats));
+}
+
+bool ChessEngine::running() {
+	return engine_.running();
+}
+
+void ChessEngine::kill() {
+	std::error_code ec;
+	// Failure here means the process is already gone, which is what we wanted.
+	engine_.terminate(ec);
+}
+
+void ChessEngine::wait_ready() {
+	send_command("isready");
+	std::string line;
+	do {
+		std::getline(engine_output_, line);
+	} while(line.compare(0u, 7u, "readyok") != 0);
+	if(auto latency = std::atomic_load(&latency_)) {
+		record_since(latency->isready_to_readyok, isready_sent_, clock_type::now());
+		isready_sent_ = 0;
+	}
 }
 
 void ChessEngine::parse_uci_options() {
@@ -191,7 +258,179 @@ bool ChessEngine::parse_next_uci_option() {
 
 
 void ChessEngine::set_position(const GameSnapshot& snapshot) {
+	stop_pondering();
 	send_command(fmt::format("position fen {}", forsyth_edwards_encoding(snapshot)));
+	position_hash_ = zobrist_hash(snapshot);
+	position_ = snapshot;
+}
+
+void ChessEngine::set_position(const GameSnapshot& snapshot, const std::vector<PackedMove>& moves) {
+	if(moves.empty()) {
+		set_position(snapshot);
+		return;
+	}
+	stop_pondering();
+	std::string cmd = fmt::format("position fen {} moves", forsyth_edwards_encoding(snapshot));
+	for(PackedMove mv: moves) {
+		cmd += ' ';
+		cmd += long_algebraic_notation(mv).view();
+	}
+	send_command(cmd);
+	auto position = snapshot;
+	for(PackedMove mv: moves) {
+		apply_move(position, mv);
+	}
+	position_ = position;
+	// The engine's result may depend on repetitions among 'moves', so it isn't cached.
+	position_hash_ = std::nullopt;
+}
+
+void ChessEngine::set_analysis_cache(std::shared_ptr<AnalysisCache> cache) {
+	cache_ = std::move(cache);
+}
+
+void ChessEngine::set_opening_book(std::shared_ptr<const PolyglotBook> book) {
+	book_ = std::move(book);
+}
+
+SearchResult ChessEngine::go(const UCIGoArgs& args, const info_callback& on_info) {
+	// Results of restricted or open-ended searches aren't comparable to a plain search of the position.
+	bool multipv = args.multipv and *args.multipv > 1u;
+	bool plain = args.searchmoves.empty() and not args.mate and not args.ponder and not args.infinite and not multipv;
+	if(book_ and position_ and plain) {
+		if(auto mv = book_->choose(*position_, book_rng_())) {
+			SearchResult result;
+			result.best_move = *mv;
+			return result;
+		}
+	}
+	bool cacheable = cache_ and position_hash_ and plain;
+	if(cacheable and args.depth) {
+		if(auto hit = cache_->find(*position_hash_, *args.depth)) {
+			return *hit;
+		}
+	}
+	stop_pondering();
+	// A search without 'multipv' gets a single line again, whatever the last one asked for.
+	if(args.multipv or options_.find("MultiPV") != options_.end()) {
+		auto& opt = option_at("MultiPV").spin();
+		auto wanted = args.multipv ? *args.multipv : std::size_t(1u);
+		if(opt.value != wanted) {
+			set_spin_option("MultiPV", wanted);
+		}
+	}
+	send_command(go_command(args));
+	auto result = read_search_result(on_info);
+	if(cacheable) {
+		cache_->insert(*position_hash_, result);
+	}
+	return result;
+}
+
+SearchResult ChessEngine::read_search_result(const info_callback& on_info) {
+	SearchResult result;
+	std::string line;
+	// Capture the stats once; the search shouldn't switch histograms halfway through.
+	auto latency = std::atomic_load(&latency_);
+	for(;;) {
+		std::getline(engine_output_, line);
+		auto received = clock_type::now();
+		auto first = line.cbegin();
+		auto last = line.cend();
+		if(line.compare(0u, 5u, "info ") == 0) {
+			if(latency and awaiting_first_info_.exchange(false)) {
+				record_since(latency->go_to_first_info, go_sent_, received);
+			}
+			uci::InfoLine info;
+			bool parsed = uci::x3::phrase_parse(first, last, uci::uci_info_parser, uci::x3::space, info);
+			if(latency) {
+				latency->line_parse.record(clock_type::now() - received);
+			}
+			if(parsed) {
+				result.update(info);
+				if(on_info) {
+					on_info(info);
+				}
+			}
+		} else if(line.compare(0u, 8u, "bestmove") == 0) {
+			uci::BestMove bestmove;
+			if(not uci::x3::phrase_parse(first, last, uci::uci_bestmove_parser, uci::x3::space, bestmove)) {
+				throw std::runtime_error(fmt::format("Bad UCI bestmove string: '{}'", line));
+			}
+			result.update(bestmove);
+			if(latency) {
+				latency->line_parse.record(clock_type::now() - received);
+				record_since(latency->go_to_bestmove, go_sent_, received);
+				record_since(latency->stop_to_bestmove, stop_sent_, received);
+				record_since(latency->ponderhit_to_bestmove, ponderhit_sent_, received);
+				awaiting_first_info_ = false;
+			}
+			break;
+		}
+	}
+	return result;
+}
+
+void ChessEngine::start_pondering(
+	const GameSnapshot& position,
+	std::vector<PackedMove> moves,
+	PackedMove expected_reply,
+	UCIGoArgs args,
+	info_callback on_info
+) {
+	auto ponder_moves = moves;
+	ponder_moves.push_back(expected_reply);
+	set_position(position, ponder_moves);
+	args.ponder = true;
+	args.infinite = false;
+	send_command(go_command(args));
+	args.ponder = false;
+	auto result = std::async(std::launch::async, [this, on_info]() {
+		return read_search_result(on_info);
+	});
+	ponder_.emplace(PonderState{
+		position,
+		std::move(moves),
+		expected_reply,
+		std::move(args),
+		std::move(on_info),
+		std::move(result)
+	});
+}
+
+SearchResult ChessEngine::opponent_moved(PackedMove reply) {
+	if(not ponder_) {
+		throw std::logic_error("ChessEngine::opponent_moved() called while not pondering.");
+	}
+	auto state = std::move(*ponder_);
+	ponder_.reset();
+	if(reply == state.expected_reply) {
+		// The reader thread is already waiting on the engine; all that's left is to
+		// tell the engine its guess was right.
+		send_command("ponderhit");
+		return state.result.get();
+	}
+	send_command("stop");
+	state.result.get();
+	state.moves.push_back(reply);
+	set_position(state.position, state.moves);
+	send_command(go_command(state.args));
+	return read_search_result(state.on_info);
+}
+
+void ChessEngine::stop_pondering() {
+	if(not ponder_) {
+		return;
+	}
+	send_command("stop");
+	auto state = std::move(*ponder_);
+	ponder_.reset();
+	// Drain the engine's answer so the next command starts from a clean stream.
+	state.result.get();
+}
+
+bool ChessEngine::is_pondering() const {
+	return ponder_.has_value();
 }
 
 } /* namespace ac */
@@ -13,7 +13,18 @@
 #include "UCI.h"
 #include "tsl/ordered_map.h"
 #include "GameSnapshot.h"
+#include "SearchResult.h"
+#include "AnalysisCache.h"
+#include "LatencyHistogram.h"
+#include "PolyglotBook.h"
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
 
 namespace ac {
 
@@ -37,8 +48,57 @@ struct UCIGoArgs {
 	std::optional<msec_type> move_time            = std::nullopt;
 	// only stop
 	bool infinite                                 = false;
+	// Number of principal variations to report.  Not part of the 'go' command; the engine's
+	// 'MultiPV' option is set before the search when this differs from its current value,
+	// and put back to 1 by the next search that leaves this unset.
+	std::optional<std::size_t> multipv            = std::nullopt;
 };
 
+inline std::string go_command(const UCIGoArgs& args) {
+	std::string cmd = "go";
+	if(not args.searchmoves.empty()) {
+		cmd += " searchmoves";
+		for(PackedMove mv: args.searchmoves) {
+			cmd += ' ';
+			cmd += long_algebraic_notation(mv).view();
+		}
+	}
+	if(args.ponder) {
+		cmd += " ponder";
+	}
+	if(args.white_remaining_msec) {
+		cmd += fmt::format(" wtime {}", args.white_remaining_msec->count());
+	}
+	if(args.black_remaining_msec) {
+		cmd += fmt::format(" btime {}", args.black_remaining_msec->count());
+	}
+	if(args.white_increment_msec) {
+		cmd += fmt::format(" winc {}", args.white_increment_msec->count());
+	}
+	if(args.black_increment_msec) {
+		cmd += fmt::format(" binc {}", args.black_increment_msec->count());
+	}
+	if(args.moves_to_go) {
+		cmd += fmt::format(" movestogo {}", *args.moves_to_go);
+	}
+	if(args.depth) {
+		cmd += fmt::format(" depth {}", *args.depth);
+	}
+	if(args.nodes) {
+		cmd += fmt::format(" nodes {}", *args.nodes);
+	}
+	if(args.mate) {
+		cmd += fmt::format(" mate {}", *args.mate);
+	}
+	if(args.move_time) {
+		cmd += fmt::format(" movetime {}", args.move_time->count());
+	}
+	if(args.infinite) {
+		cmd += " infinite";
+	}
+	return cmd;
+}
+
 struct ChessEngine {
 	struct KeyEqual: std::equal_to<std::string_view> {
 		using is_transparent = void;
@@ -52,8 +112,12 @@ struct ChessEngine {
 		std::vector<std::pair<std::string, uci::Option>>,
 		std::size_t
 	>;
+	using info_callback = std::function<void(const uci::InfoLine&)>;
 
 	ChessEngine(const char* executable_path);
+	// Stops any ponder search first; otherwise its reader thread would wait on the engine
+	// forever.
+	~ChessEngine();
 	
 	const option_map_type& options() const;
 
@@ -71,11 +135,78 @@ struct ChessEngine {
 
 	void send_command(std::string_view s);
 
-	void set_position(const GameSnapshot& board);
+	// Send 'isready' and block until the engine answers 'readyok'.
+	void wait_ready();
+
+	bool running();
 
-	void go(
-		
+	// Forcefully terminate the engine process.  A thread blocked reading the engine's output
+	// is released with an exception.  May be called from any thread.
+	void kill();
+
+	void set_position(const GameSnapshot& board);
+	// Set the position reached by playing 'moves' from 'board'.
+	void set_position(const GameSnapshot& board, const std::vector<PackedMove>& moves);
+
+	// Search the current position and block until the engine reports its best move.
+	// If an opening book is attached and has a move for this position, a weighted random
+	// book move is returned at once, with no score or PV.  Otherwise, if an analysis cache is
+	// attached and holds a result for this position that is at least as deep as 'args.depth',
+	// that result is returned without consulting the engine.
+	// Every 'info' line the engine emits during the search is passed to 'on_info'.
+	SearchResult go(const UCIGoArgs& args, const info_callback& on_info = info_callback());
+
+	void set_analysis_cache(std::shared_ptr<AnalysisCache> cache);
+
+	// Answer plain searches from 'book' whenever the position is in it.  Pass nullptr to
+	// always search.
+	void set_opening_book(std::shared_ptr<const PolyglotBook> book);
+
+	// Start a 'go ponder' search on the position reached from 'position' by 'moves' followed by
+	// 'expected_reply', usually the 'bestmove' and 'ponder' moves of the previous search.  The
+	// engine's output is consumed on a background thread (which is also where 'on_info' is
+	// called), so this returns immediately.
+	void start_pondering(
+		const GameSnapshot& position,
+		std::vector<PackedMove> moves,
+		PackedMove expected_reply,
+		UCIGoArgs args,
+		info_callback on_info = info_callback()
+	);
+
+	// The opponent replied with 'reply'.  If that is the move being pondered on, send
+	// 'ponderhit' and wait for the (already running) search to finish; otherwise stop the
+	// ponder search and search the actual position from scratch with the same limits.
+	SearchResult opponent_moved(PackedMove reply);
+
+	// Abandon the current ponder search, if any, discarding its result.
+	void stop_pondering();
+
+	bool is_pondering() const;
+
+	// Record the timings of commands and their responses into 'stats'.  Several engines may
+	// share one set of statistics.  Pass nullptr to stop recording.  Safe to call while
+	// pondering; the running search keeps the statistics it started with.
+	void set_latency_stats(std::shared_ptr<EngineLatencyStats> stats);
+	
 private:
+	using clock_type = std::chrono::steady_clock;
+
+	struct PonderState {
+		GameSnapshot position;
+		std::vector<PackedMove> moves;
+		PackedMove expected_reply;
+		UCIGoArgs args;
+		info_callback on_info;
+		std::future<SearchResult> result;
+	};
+
+	// Consume engine output up to and including the 'bestmove' line.
+	SearchResult read_search_result(const info_callback& on_info);
+
+	void record_sent(std::string_view command);
+	// Record the time from the command sent at 'sent' (if any) until 'received'.
+	static void record_since(LatencyHistogram& hist, const std::atomic<clock_type::rep>& sent, clock_type::time_point received);
 
 	uci::Option& option_at(std::string_view name);
 	const uci::Option& option_at(std::string_view name) const;
@@ -88,6 +219,21 @@ private:
 	bp::opstream engine_input_;
 	bp::child engine_;
 	option_map_type options_;
+	std::shared_ptr<AnalysisCache> cache_;
+	std::optional<std::uint64_t> position_hash_;
+	std::shared_ptr<const PolyglotBook> book_;
+	// The position last sent to the engine.
+	std::optional<GameSnapshot> position_;
+	std::mt19937_64 book_rng_{std::random_device{}()};
+	std::optional<PonderState> ponder_;
+	std::shared_ptr<EngineLatencyStats> latency_;
+	// Send times of the outstanding commands we time, as 'clock_type' ticks; zero if none.
+	// These are read from the ponder thread, hence atomic.
+	std::atomic<clock_type::rep> isready_sent_{0};
+	std::atomic<clock_type::rep> go_sent_{0};
+	std::atomic<clock_type::rep> stop_sent_{0};
+	std::atomic<clock_type::rep> ponderhit_sent_{0};
+	std::atomic<bool> awaiting_first_info_{false};
 };
 
 
@@ -163,6 +163,10 @@ constexpr std::optional<ChessPieceColor> color(std::optional<ChessPiece> piece)
 	return piece ? some(color(*piece)) : std::nullopt;
 }
 
+constexpr ChessPieceColor opposite_color(ChessPieceColor c) {
+	return c == ChessPieceColor::White ? ChessPieceColor::Black : ChessPieceColor::White;
+}
+
 
 constexpr ChessPieceKind kind(ChessPiece piece) {
 	return static_cast<ChessPieceKind>(static_cast<unsigned>(piece) % 6u);
@@ -254,6 +258,24 @@ constexpr char forsyth_edwards_encoding(ChessPiece piece) {
 	}
 }
 
+constexpr std::optional<ChessPiece> chess_piece_from_fen_char(char c) {
+	switch(c) {
+	case 'P': return ChessPiece::WhitePawn;
+	case 'N': return ChessPiece::WhiteKnight;
+	case 'B': return ChessPiece::WhiteBishop;
+	case 'R': return ChessPiece::WhiteRook;
+	case 'Q': return ChessPiece::WhiteQueen;
+	case 'K': return ChessPiece::WhiteKing;
+	case 'p': return ChessPiece::BlackPawn;
+	case 'n': return ChessPiece::BlackKnight;
+	case 'b': return ChessPiece::BlackBishop;
+	case 'r': return ChessPiece::BlackRook;
+	case 'q': return ChessPiece::BlackQueen;
+	case 'k': return ChessPiece::BlackKing;
+	default:  return std::nullopt;
+	}
+}
+
 constexpr const char* forsyth_edwards_encoding(CastleStatus status) {
 	constexpr auto WK = CastleStatus::WhiteKingside;
 	constexpr auto WQ = CastleStatus::WhiteQueenside;
@@ -0,0 +1,131 @@
+#ifndef AC_DRAW_DETECTION_H
+#define AC_DRAW_DETECTION_H
+
+#include "GameSnapshot.h"
+#include "GameHistory.h"
+#include "Zobrist.h"
+#include <array>
+#include <cstdint>
+
+namespace ac {
+
+enum class DrawStatus: unsigned char {
+	None,
+	// Claimable by either player.
+	ThreefoldRepetition,
+	FiftyMoveRule,
+	// Drawn without a claim.
+	FivefoldRepetition,
+	SeventyFiveMoveRule
+};
+
+constexpr bool is_automatic_draw(DrawStatus status) {
+	return status == DrawStatus::FivefoldRepetition or status == DrawStatus::SeventyFiveMoveRule;
+}
+
+// Hashes of the most recent positions of a game, kept in a ring.  Repetition checks only look
+// back as far as the last capture or pawn move, since no earlier position can recur, so the
+// ring needs no more entries than the halfmove clock can count.
+//
+// Positions are compared by Zobrist hash, which counts an en passant target as part of the
+// position even when no capture onto it is possible.  This can only miss a repetition, never
+// report a false one (barring hash collisions).
+//
+// Draw status says nothing about checkmate; a mate delivered on the move that completes
+// the 50 or 75 move count takes precedence, which is the caller's business.
+struct RepetitionHistory {
+	static constexpr std::size_t capacity = max_halfmove_clock + 1u;
+
+	explicit RepetitionHistory(const GameSnapshot& start) {
+		reset(start);
+	}
+
+	// Rebuild from the tail of a game: only the plies since the last irreversible move are
+	// replayed.
+	explicit RepetitionHistory(const GameHistory& history) {
+		auto plies = history.turn_count();
+		auto clock = history.current_snapshot().temporal_state.halfmove_clock;
+		auto first = plies - std::min<std::size_t>(clock, plies);
+		auto snapshot = history.turn_snapshot(first);
+		reset(snapshot);
+		for(auto i = first; i < plies; ++i) {
+			apply_move(snapshot, history.move(i));
+			push(snapshot);
+		}
+	}
+
+	void reset(const GameSnapshot& start) {
+		size_ = 0u;
+		head_ = 0u;
+		push(start);
+	}
+
+	// Record the position reached by the move just played.
+	void push(const GameSnapshot& snapshot) {
+		push(zobrist_hash(snapshot), snapshot.temporal_state.halfmove_clock);
+	}
+
+	void push(std::uint64_t hash, std::size_t halfmove_clock) {
+		head_ = (head_ + 1u) % capacity;
+		hashes_[head_] = hash;
+		clocks_[head_] = static_cast<std::uint8_t>(std::min(halfmove_clock, max_halfmove_clock));
+		size_ = std::min(size_ + 1u, capacity);
+	}
+
+	// Forget the most recent position, e.g. when a move is taken back.
+	void pop() {
+		assert(size_ > 1u);
+		head_ = (head_ + capacity - 1u) % capacity;
+		--size_;
+	}
+
+	std::size_t halfmove_clock() const {
+		return clocks_[head_];
+	}
+
+	// How many times the current position has occurred, counting this occurrence.
+	std::size_t repetition_count() const {
+		auto hash = hashes_[head_];
+		auto window = std::min<std::size_t>(halfmove_clock(), size_ - 1u);
+		std::size_t count = 1u;
+		// Only positions with the same side to move can match, so step two plies at a time.
+		for(std::size_t back = 2u; back <= window; back += 2u) {
+			if(hashes_[(head_ + capacity - back) % capacity] == hash) {
+				++count;
+			}
+		}
+		return count;
+	}
+
+	DrawStatus draw_status() const {
+		auto clock = halfmove_clock();
+		if(clock < 8u) {
+			// A position can recur at best every four plies, so a third occurrence needs eight.
+			return DrawStatus::None;
+		}
+		auto repetitions = repetition_count();
+		if(repetitions >= 5u) {
+			return DrawStatus::FivefoldRepetition;
+		}
+		if(clock >= 150u) {
+			return DrawStatus::SeventyFiveMoveRule;
+		}
+		if(repetitions >= 3u) {
+			return DrawStatus::ThreefoldRepetition;
+		}
+		if(clock >= 100u) {
+			return DrawStatus::FiftyMoveRule;
+		}
+		return DrawStatus::None;
+	}
+
+private:
+	std::array<std::uint64_t, capacity> hashes_ = {};
+	std::array<std::uint8_t, capacity> clocks_ = {};
+	std::size_t head_ = 0u;
+	std::size_t size_ = 0u;
+};
+
+} /* namespace ac */
+
+#endif /* AC_DRAW_DETECTION_H */
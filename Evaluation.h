@@ -0,0 +1,198 @@
+#ifndef AC_EVALUATION_H
+#define AC_EVALUATION_H
+
+#include "Board.h"
+#include "ChessPiece.h"
+#include "Move.h"
+#include <array>
+#include <cassert>
+
+namespace ac {
+
+namespace detail {
+
+// Piece-square bonuses in centipawns from white's point of view, laid out as the board is
+// drawn: the first row of each table is the 8th rank, a-file first.
+using PieceSquareTable = std::array<int, 64u>;
+
+inline constexpr PieceSquareTable pawn_square_table = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 50,  50,  50,  50,  50,  50,  50,  50,
+	 10,  10,  20,  30,  30,  20,  10,  10,
+	  5,   5,  10,  25,  25,  10,   5,   5,
+	  0,   0,   0,  20,  20,   0,   0,   0,
+	  5,  -5, -10,   0,   0, -10,  -5,   5,
+	  5,  10,  10, -20, -20,  10,  10,   5,
+	  0,   0,   0,   0,   0,   0,   0,   0
+};
+
+inline constexpr PieceSquareTable knight_square_table = {
+	-50, -40, -30, -30, -30, -30, -40, -50,
+	-40, -20,   0,   0,   0,   0, -20, -40,
+	-30,   0,  10,  15,  15,  10,   0, -30,
+	-30,   5,  15,  20,  20,  15,   5, -30,
+	-30,   0,  15,  20,  20,  15,   0, -30,
+	-30,   5,  10,  15,  15,  10,   5, -30,
+	-40, -20,   0,   5,   5,   0, -20, -40,
+	-50, -40, -30, -30, -30, -30, -40, -50
+};
+
+inline constexpr PieceSquareTable bishop_square_table = {
+	-20, -10, -10, -10, -10, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,  10,  10,   5,   0, -10,
+	-10,   5,   5,  10,  10,   5,   5, -10,
+	-10,   0,  10,  10,  10,  10,   0, -10,
+	-10,  10,  10,  10,  10,  10,  10, -10,
+	-10,   5,   0,   0,   0,   0,   5, -10,
+	-20, -10, -10, -10, -10, -10, -10, -20
+};
+
+inline constexpr PieceSquareTable rook_square_table = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  5,  10,  10,  10,  10,  10,  10,   5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	  0,   0,   0,   5,   5,   0,   0,   0
+};
+
+inline constexpr PieceSquareTable queen_square_table = {
+	-20, -10, -10,  -5,  -5, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,   5,   5,   5,   0, -10,
+	 -5,   0,   5,   5,   5,   5,   0,  -5,
+	  0,   0,   5,   5,   5,   5,   0,  -5,
+	-10,   5,   5,   5,   5,   5,   0, -10,
+	-10,   0,   5,   0,   0,   0,   0, -10,
+	-20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+inline constexpr PieceSquareTable king_square_table = {
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-20, -30, -30, -40, -40, -30, -30, -20,
+	-10, -20, -20, -20, -20, -20, -20, -10,
+	 20,  20,   0,   0,   0,   0,  20,  20,
+	 20,  30,  10,   0,   0,  10,  30,  20
+};
+
+constexpr const PieceSquareTable& piece_square_table(ChessPieceKind k) {
+	switch(k) {
+	default: assert(!"Bad piece kind.");
+	case ChessPieceKind::Pawn:   return pawn_square_table;
+	case ChessPieceKind::Knight: return knight_square_table;
+	case ChessPieceKind::Bishop: return bishop_square_table;
+	case ChessPieceKind::Rook:   return rook_square_table;
+	case ChessPieceKind::Queen:  return queen_square_table;
+	case ChessPieceKind::King:   return king_square_table;
+	}
+}
+
+} /* namespace detail */
+
+// Material plus piece-square bonus of 'piece' standing on 'pos', in centipawns, positive for
+// white and negative for black.
+constexpr int piece_square_value(ChessPiece piece, BoardPos pos) {
+	auto k = kind(piece);
+	auto c = index(col(pos));
+	auto r = index(row(pos));
+	// Black's tables are white's mirrored top to bottom.
+	auto table_row = color(piece) == ChessPieceColor::White ? 7u - r : r;
+	auto value = detail::piece_square_table(k)[table_row * 8u + c];
+	if(k != ChessPieceKind::King) {
+		value += 100 * static_cast<int>(material_value(k));
+	}
+	return color(piece) == ChessPieceColor::White ? value : -value;
+}
+
+// Static evaluation made of material and piece-square tables.  It is kept up to date by
+// apply_move()/undo_move() below, so reading it costs nothing beyond the move itself.
+struct Evaluation {
+	// Score from white's point of view.
+	constexpr int white_score() const {
+		return white_score_;
+	}
+
+	// Score from the point of view of 'to_move'.
+	constexpr int score(ChessPieceColor to_move) const {
+		return to_move == ChessPieceColor::White ? white_score_ : -white_score_;
+	}
+
+	constexpr void add(ChessPiece piece, BoardPos pos) {
+		white_score_ += piece_square_value(piece, pos);
+	}
+
+	constexpr void remove(ChessPiece piece, BoardPos pos) {
+		white_score_ -= piece_square_value(piece, pos);
+	}
+
+	constexpr void adjust(int delta) {
+		white_score_ += delta;
+	}
+
+	friend constexpr bool operator==(Evaluation l, Evaluation r) {
+		return l.white_score_ == r.white_score_;
+	}
+
+	friend constexpr bool operator!=(Evaluation l, Evaluation r) {
+		return not (l == r);
+	}
+
+private:
+	int white_score_ = 0;
+};
+
+// Evaluate 'board' from scratch.
+constexpr Evaluation evaluate(const Board& board) {
+	Evaluation eval;
+	for(std::size_t i = 0u; i < 12u; ++i) {
+		auto piece = chess_piece_from_index(i);
+		for(auto pos: board.positions(piece).positions()) {
+			eval.add(piece, pos);
+		}
+	}
+	return eval;
+}
+
+// Change in the evaluation caused by playing the legal move 'mv' on 'board'.
+constexpr int evaluation_delta(const Board& board, PackedMove mv) {
+	auto from = mv.start_position();
+	auto to = mv.end_position();
+	auto piece = board[from];
+	assert(piece);
+	auto c = color(*piece);
+	auto moved_kind = kind(*piece);
+	auto delta = -piece_square_value(*piece, from);
+	delta += piece_square_value(mv.promotion() ? c + *mv.promotion() : *piece, to);
+	if(auto captured = board[to]) {
+		delta -= piece_square_value(*captured, to);
+	} else if(moved_kind == ChessPieceKind::Pawn and col(from) != col(to)) {
+		delta -= piece_square_value(opposite_color(c) + ChessPieceKind::Pawn, make_board_pos(col(to), row(from)));
+	} else if(moved_kind == ChessPieceKind::King and (index(col(from)) == index(col(to)) + 2u or index(col(to)) == index(col(from)) + 2u)) {
+		auto kingside = col(to) == 'G'_col;
+		auto rook = c + ChessPieceKind::Rook;
+		delta -= piece_square_value(rook, make_board_pos(kingside ? 'H'_col : 'A'_col, row(from)));
+		delta += piece_square_value(rook, make_board_pos(kingside ? 'F'_col : 'D'_col, row(from)));
+	}
+	return delta;
+}
+
+// Update 'eval' for 'mv' being played on 'board', the position before the move.
+constexpr void apply_move(Evaluation& eval, const Board& board, PackedMove mv) {
+	eval.adjust(evaluation_delta(board, mv));
+}
+
+// Take 'mv' back out of 'eval'.  'board' is again the position before the move, i.e. the
+// board once the move has been undone.
+constexpr void undo_move(Evaluation& eval, const Board& board, PackedMove mv) {
+	eval.adjust(-evaluation_delta(board, mv));
+}
+
+} /* namespace ac */
+
+#endif /* AC_EVALUATION_H */
@@ -1,35 +1,40 @@
 #ifndef AC_GAME_H
 #define AC_GAME_H
 
+#include "attack_sets.h"
 #include "ChessPiece.h"
+#include "GameSnapshot.h"
 #include "Move.h"
-#include <vector>
+#include "move_generation.h"
+#include <fmt/format.h>
+#include <stdexcept>
 
 namespace ac {
 
 
 struct BasicGame {
-private:
-	using sink_type = boost::coroutines::asymmetric_coroutine<Move>::push_type;
-public:
-	using moveset_type = boost::coroutines::asymmetric_coroutine<Move>;
-
-	Game() = default;
+	BasicGame() = default;
 
 	ChessPieceColor active_color() const {
 		return game_state_.active_color;
 	}
 
-	move_generator valid_moves(ChessPieceColor c) const {
-		return compute_valid_moves(c, board(), game_state_);
+	MoveList valid_moves(ChessPieceColor c) const {
+		auto state = game_state_;
+		state.active_color = c;
+		MoveList moves;
+		generate_legal_moves(board_.decompressed(), state, moves);
+		return moves;
 	}
 
-	move_generator valid_moves() const {
+	MoveList valid_moves() const {
 		return valid_moves(active_color());
 	}
 
-	move_generator attackers(BoardPos pos) const {
-		return compute_attackers(pos, board() 
+	// Pieces of color 'c' attacking 'pos'.
+	BitBoard attackers(BoardPos pos, ChessPieceColor c) const {
+		auto board = board_.decompressed();
+		return attackers_of(board, pos, c, board.all_positions());
 	}
 
 	CompressedBoard board() const {
@@ -37,20 +42,18 @@ public:
 	}
 
 	[[nodiscard]]
-	bool move_is_valid(Move move) {
-		// Theres a much more efficient way of doing this but this is all we do for now.
-		for(Move mv: valid_moves()) {
-			if(mv == move) {
-				return true;
-			}
-		}
-		return false;
+	bool move_is_valid(PackedMove move) const {
+		return is_legal(board_.decompressed(), game_state_, move);
 	}
 
-	void apply_move(Move move) {
+	void apply_move(PackedMove move) {
 		if(not move_is_valid(move)) {
-			throw std::runtime_error(
+			throw std::runtime_error(fmt::format("Illegal move in position '{}'.", forsyth_edwards_encoding(snapshot())));
 		}
+		auto next = snapshot();
+		ac::apply_move(next, move);
+		board_ = next.board;
+		game_state_ = next.temporal_state;
 	}
 
 	GameSnapshot snapshot() const {
@@ -0,0 +1,127 @@
+#include "GameArchive.h"
+#include <fmt/format.h>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace ac {
+
+GameArchive::GameArchive(const bfs::path& path):
+	file_(path.string().c_str(), bip::read_only),
+	region_(file_, bip::read_only)
+{
+	auto size = region_.get_size();
+	if(size < sizeof(archive::FileHeader)) {
+		throw std::runtime_error(fmt::format("Game archive '{}' is truncated.", path.string()));
+	}
+	const auto& hdr = header();
+	if(hdr.magic != archive::magic or hdr.version != archive::version or hdr.record_alignment != archive::record_alignment) {
+		throw std::runtime_error(fmt::format("'{}' is not a game archive.", path.string()));
+	}
+	if(hdr.index_offset % alignof(std::uint64_t) != 0u
+		or hdr.index_offset > size
+		or hdr.game_count > (size - hdr.index_offset) / sizeof(std::uint64_t))
+	{
+		throw std::runtime_error(fmt::format("Game archive '{}' has a corrupt index.", path.string()));
+	}
+}
+
+const archive::FileHeader& GameArchive::header() const {
+	return *static_cast<const archive::FileHeader*>(region_.get_address());
+}
+
+const std::uint64_t* GameArchive::index() const {
+	return reinterpret_cast<const std::uint64_t*>(static_cast<const char*>(region_.get_address()) + header().index_offset);
+}
+
+const archive::RecordHeader* GameArchive::record_at(std::uint64_t offset) const {
+	return reinterpret_cast<const archive::RecordHeader*>(static_cast<const char*>(region_.get_address()) + offset);
+}
+
+GameRecordView GameArchive::game(std::size_t id) const {
+	if(id >= size()) {
+		throw std::out_of_range(fmt::format("Game id {} is out of range for an archive of {} games.", id, size()));
+	}
+	auto offset = index()[id];
+	auto limit = header().index_offset;
+	if(offset % archive::record_alignment != 0u or offset > limit or limit - offset < sizeof(archive::RecordHeader)) {
+		throw std::runtime_error(fmt::format("Game archive record {} has a corrupt offset.", id));
+	}
+	const auto* record = record_at(offset);
+	if(record->ply_count > (limit - offset - sizeof(archive::RecordHeader)) / sizeof(PackedMove)) {
+		throw std::runtime_error(fmt::format("Game archive record {} is truncated.", id));
+	}
+	return GameRecordView(record);
+}
+
+GameArchiveWriter::GameArchiveWriter(const bfs::path& path):
+	out_(path.string(), std::ios::binary | std::ios::trunc),
+	offset_(0u),
+	offsets_()
+{
+	if(not out_) {
+		throw std::runtime_error(fmt::format("Failed to create game archive '{}'.", path.string()));
+	}
+	out_.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+	// Placeholder; the real header is written by finish() once the index location is known.
+	archive::FileHeader header{};
+	out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	offset_ = sizeof(header);
+	pad();
+}
+
+GameArchiveWriter::~GameArchiveWriter() {
+	if(not finished_) {
+		try {
+			finish();
+		} catch(...) {
+			// Nothing sensible to do from a destructor; the file is left without an index
+			// and will be rejected when opened.
+		}
+	}
+}
+
+void GameArchiveWriter::pad() {
+	static constexpr std::array<char, archive::record_alignment> zeros = {};
+	auto excess = offset_ % archive::record_alignment;
+	if(excess != 0u) {
+		auto padding = archive::record_alignment - excess;
+		out_.write(zeros.data(), static_cast<std::streamsize>(padding));
+		offset_ += padding;
+	}
+}
+
+std::size_t GameArchiveWriter::append(const GameSnapshot& start, const PackedMove* moves, std::size_t ply_count, GameMetadata metadata) {
+	assert(not finished_);
+	assert(ply_count <= std::numeric_limits<std::uint32_t>::max());
+	archive::RecordHeader record{};
+	record.start = start;
+	record.metadata = metadata;
+	record.ply_count = static_cast<std::uint32_t>(ply_count);
+	offsets_.push_back(offset_);
+	out_.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	out_.write(reinterpret_cast<const char*>(moves), static_cast<std::streamsize>(ply_count * sizeof(PackedMove)));
+	offset_ += sizeof(record) + ply_count * sizeof(PackedMove);
+	pad();
+	return offsets_.size() - 1u;
+}
+
+void GameArchiveWriter::finish() {
+	if(finished_) {
+		return;
+	}
+	finished_ = true;
+	archive::FileHeader header{
+		archive::magic,
+		archive::version,
+		static_cast<std::uint32_t>(archive::record_alignment),
+		static_cast<std::uint64_t>(offsets_.size()),
+		offset_
+	};
+	out_.write(reinterpret_cast<const char*>(offsets_.data()), static_cast<std::streamsize>(offsets_.size() * sizeof(std::uint64_t)));
+	out_.seekp(0);
+	out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out_.close();
+}
+
+} /* namespace ac */
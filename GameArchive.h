@@ -0,0 +1,178 @@
+#ifndef AC_GAME_ARCHIVE_H
+#define AC_GAME_ARCHIVE_H
+
+#include "GameHistory.h"
+#include "GameSnapshot.h"
+#include "Move.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem/path.hpp>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+namespace ac {
+
+namespace bip = boost::interprocess;
+namespace bfs = boost::filesystem;
+
+enum class GameResult: unsigned char {
+	Unknown,
+	WhiteWins,
+	BlackWins,
+	Draw
+};
+
+struct GameMetadata {
+	GameResult result       = GameResult::Unknown;
+	// Zero if unknown.
+	std::uint16_t white_elo = 0u;
+	std::uint16_t black_elo = 0u;
+};
+
+// On-disk archive of many games.  The file is a header, the game records back to back, and an
+// index of record offsets at the end.  Each record is a fixed-size header (start position,
+// metadata and ply count) followed by the game's PackedMoves, padded to 8 bytes.  Records are
+// laid out exactly as in memory, so reading one is a pointer into the mapped file.
+//
+// Like the analysis cache, the file uses the host's byte order and struct layout.
+namespace archive {
+
+struct FileHeader {
+	std::array<char, 8u> magic;
+	std::uint32_t version;
+	std::uint32_t record_alignment;
+	std::uint64_t game_count;
+	std::uint64_t index_offset;
+};
+
+struct RecordHeader {
+	GameSnapshot start;
+	GameMetadata metadata;
+	std::uint32_t ply_count;
+};
+
+inline constexpr std::array<char, 8u> magic = {'A', 'C', 'G', 'A', 'M', 'E', 'S', '\0'};
+inline constexpr std::uint32_t version = 1u;
+inline constexpr std::size_t record_alignment = 8u;
+
+static_assert(std::is_trivially_copyable_v<FileHeader>);
+static_assert(std::is_trivially_copyable_v<RecordHeader>);
+static_assert(alignof(RecordHeader) <= record_alignment);
+static_assert(alignof(PackedMove) <= record_alignment);
+
+} /* namespace archive */
+
+// A game stored in a mapped archive.  Only valid while the archive is open.
+struct GameRecordView {
+	const GameSnapshot& start_snapshot() const {
+		return header_->start;
+	}
+
+	const GameMetadata& metadata() const {
+		return header_->metadata;
+	}
+
+	std::size_t ply_count() const {
+		return header_->ply_count;
+	}
+
+	const PackedMove* begin() const {
+		return reinterpret_cast<const PackedMove*>(header_ + 1);
+	}
+
+	const PackedMove* end() const {
+		return begin() + ply_count();
+	}
+
+	PackedMove operator[](std::size_t i) const {
+		assert(i < ply_count());
+		return begin()[i];
+	}
+
+	GameHistory to_history() const {
+		GameHistory history(start_snapshot());
+		history.reserve(ply_count());
+		for(PackedMove mv: *this) {
+			history.push_back(mv);
+		}
+		return history;
+	}
+
+private:
+	friend struct GameArchive;
+
+	explicit GameRecordView(const archive::RecordHeader* header):
+		header_(header)
+	{
+
+	}
+
+	const archive::RecordHeader* header_;
+};
+
+// Read-only view of an archive file.
+struct GameArchive {
+	explicit GameArchive(const bfs::path& path);
+
+	GameArchive(const GameArchive&) = delete;
+	GameArchive& operator=(const GameArchive&) = delete;
+
+	std::size_t size() const {
+		return header().game_count;
+	}
+
+	// The game with the given id (its position in the archive).  Throws if out of range.
+	GameRecordView game(std::size_t id) const;
+
+	GameRecordView operator[](std::size_t id) const {
+		assert(id < size());
+		return GameRecordView(record_at(index()[id]));
+	}
+
+private:
+	const archive::FileHeader& header() const;
+	const std::uint64_t* index() const;
+	const archive::RecordHeader* record_at(std::uint64_t offset) const;
+
+	bip::file_mapping file_;
+	bip::mapped_region region_;
+};
+
+// Streams games into a new archive file.  The index is written by finish(), which the
+// destructor calls if it hasn't been called already.
+struct GameArchiveWriter {
+	explicit GameArchiveWriter(const bfs::path& path);
+	~GameArchiveWriter();
+
+	GameArchiveWriter(const GameArchiveWriter&) = delete;
+	GameArchiveWriter& operator=(const GameArchiveWriter&) = delete;
+
+	// Append a game and return its id.
+	std::size_t append(const GameSnapshot& start, const PackedMove* moves, std::size_t ply_count, GameMetadata metadata = GameMetadata());
+
+	std::size_t append(const GameHistory& history, GameMetadata metadata = GameMetadata()) {
+		return append(history.start_snapshot(), history.moves().data(), history.turn_count(), metadata);
+	}
+
+	std::size_t size() const {
+		return offsets_.size();
+	}
+
+	void finish();
+
+private:
+	void pad();
+
+	std::ofstream out_;
+	std::uint64_t offset_ = 0u;
+	std::vector<std::uint64_t> offsets_;
+	bool finished_ = false;
+};
+
+} /* namespace ac */
+
+#endif /* AC_GAME_ARCHIVE_H */
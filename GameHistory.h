@@ -2,33 +2,97 @@
 #define AC_GAME_HISTORY_H
 
 #include "GameSnapshot.h"
+#include "Move.h"
 #include <vector>
 
 namespace ac {
 
+// The moves of a game as a packed log (2 bytes per ply) plus a snapshot of the position every
+// 'keyframe_interval' plies.  Reaching any ply replays at most 'keyframe_interval - 1' moves
+// from the nearest earlier keyframe, and keyframes add well under a byte per ply on top of the
+// log.
 struct GameHistory {
-	
+	static constexpr std::size_t keyframe_interval = 64u;
+
 	GameHistory(GameSnapshot start_state):
-		game_(start_state)
+		moves_(),
+		keyframes_{start_state},
+		current_(start_state)
 	{
-	
+
 	}
 
-	std::size_t turn_count(std::size_t turn_number) const {
+	// Number of plies played.
+	std::size_t turn_count() const {
 		return moves_.size();
 	}
 
+	// The position after the first 'turn_number' plies; 0 gives the starting position.
 	GameSnapshot turn_snapshot(std::size_t turn_number) const {
-		
+		assert(turn_number <= moves_.size());
+		if(turn_number == moves_.size()) {
+			return current_;
+		}
+		auto keyframe = turn_number / keyframe_interval;
+		auto snapshot = keyframes_[keyframe];
+		for(auto i = keyframe * keyframe_interval; i < turn_number; ++i) {
+			apply_move(snapshot, moves_[i]);
+		}
+		return snapshot;
+	}
+
+	const GameSnapshot& start_snapshot() const {
+		return keyframes_.front();
+	}
+
+	const GameSnapshot& current_snapshot() const {
+		return current_;
 	}
 
 	ChessPieceColor current_turn() const {
-		
+		return current_.temporal_state.active_color;
+	}
+
+	// The move played at ply 'turn_number' (0-based).
+	PackedMove move(std::size_t turn_number) const {
+		assert(turn_number < moves_.size());
+		return moves_[turn_number];
 	}
-	
+
+	const std::vector<PackedMove>& moves() const {
+		return moves_;
+	}
+
+	// Append a (legal) move to the game.
+	void push_back(PackedMove mv) {
+		apply_move(current_, mv);
+		moves_.push_back(mv);
+		if(moves_.size() % keyframe_interval == 0u) {
+			keyframes_.push_back(current_);
+		}
+	}
+
+	// Drop every ply after the first 'turn_number', e.g. to take moves back.
+	void truncate(std::size_t turn_number) {
+		assert(turn_number <= moves_.size());
+		if(turn_number == moves_.size()) {
+			return;
+		}
+		current_ = turn_snapshot(turn_number);
+		moves_.resize(turn_number);
+		keyframes_.resize(turn_number / keyframe_interval + 1u);
+	}
+
+	void reserve(std::size_t plies) {
+		moves_.reserve(plies);
+		keyframes_.reserve(plies / keyframe_interval + 1u);
+	}
+
 private:
-	GameSnapshot game_;
-	std::vector<SimpleMove> moves_;
+	std::vector<PackedMove> moves_;
+	// keyframes_[i] is the position after i * keyframe_interval plies.
+	std::vector<GameSnapshot> keyframes_;
+	GameSnapshot current_;
 };
 
 } /* namespace ac */
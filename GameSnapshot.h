@@ -4,6 +4,10 @@
 #include "Board.h"
 #include "ChessPiece.h"
 #include <limits>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <fmt/format.h>
 
 namespace ac {
 
@@ -16,19 +20,201 @@ struct TemporalGameState {
 	bool en_passant_possible     : 1u;
 	// The current en passant target, if any.
 	BoardPos en_passant_target   : 6u; /* Ignore gcc's warning about this bit field being too small */
-	// Number of half-moves since the last piece capture or pawn advance (for the 50 move draw rule).
-	std::size_t halfmove_clock   : 6u;
+	// Number of half-moves since the last piece capture or pawn advance (for the 50 and 75 move
+	// draw rules).  Saturates at 'max_halfmove_clock', well past the 150 the 75 move rule needs.
+	std::size_t halfmove_clock   : 8u;
 	// Total number of fullmoves.
 	std::size_t fullmove_number  : 14u;
 };
 
 static_assert(sizeof(TemporalGameState) <= 8u);
 
+inline constexpr std::size_t max_halfmove_clock = (std::size_t(1u) << 8u) - 1u;
+
+inline constexpr std::string_view standard_starting_fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
 struct GameSnapshot {
 	CompressedBoard board;
 	TemporalGameState temporal_state;
+
+	// Parse a full FEN string, or just its first four fields (as found in EPD records),
+	// in which case the clocks default to 0 and 1.
+	static GameSnapshot decode_fen_string(std::string_view fenstr);
 };
 
+inline GameSnapshot GameSnapshot::decode_fen_string(std::string_view fenstr) {
+	auto bad_fen = [&](const char* why) {
+		return std::runtime_error(fmt::format("Bad FEN string ({}): '{}'", why, fenstr));
+	};
+	std::string_view fields[6u];
+	std::size_t field_count = 0u;
+	for(std::string_view rest = fenstr; not rest.empty();) {
+		auto start = rest.find_first_not_of(' ');
+		if(start == std::string_view::npos) {
+			break;
+		}
+		rest.remove_prefix(start);
+		auto stop = std::min(rest.find(' '), rest.size());
+		if(field_count == 6u) {
+			throw bad_fen("too many fields");
+		}
+		fields[field_count++] = rest.substr(0u, stop);
+		rest.remove_prefix(stop);
+	}
+	if(field_count != 4u and field_count != 6u) {
+		throw bad_fen("expected 4 or 6 fields");
+	}
+	GameSnapshot snapshot{};
+	std::size_t row_idx = 7u;
+	std::size_t col_idx = 0u;
+	for(char c: fields[0]) {
+		if(c == '/') {
+			if(col_idx != 8u or row_idx == 0u) {
+				throw bad_fen("misplaced '/'");
+			}
+			--row_idx;
+			col_idx = 0u;
+		} else if(c >= '1' and c <= '8') {
+			col_idx += c - '0';
+		} else if(auto piece = chess_piece_from_fen_char(c); piece and col_idx < 8u) {
+			snapshot.board[{row_from_index(row_idx), col_from_index(col_idx)}] = *piece;
+			++col_idx;
+		} else {
+			throw bad_fen("bad piece placement");
+		}
+		if(col_idx > 8u) {
+			throw bad_fen("row too long");
+		}
+	}
+	if(row_idx != 0u or col_idx != 8u) {
+		throw bad_fen("too few squares");
+	}
+	auto& state = snapshot.temporal_state;
+	if(fields[1] == "w") {
+		state.active_color = ChessPieceColor::White;
+	} else if(fields[1] == "b") {
+		state.active_color = ChessPieceColor::Black;
+	} else {
+		throw bad_fen("bad active color");
+	}
+	auto castle_status = CastleStatus::None;
+	if(fields[2] != "-") {
+		for(char c: fields[2]) {
+			switch(c) {
+			case 'K': castle_status |= CastleStatus::WhiteKingside;  break;
+			case 'Q': castle_status |= CastleStatus::WhiteQueenside; break;
+			case 'k': castle_status |= CastleStatus::BlackKingside;  break;
+			case 'q': castle_status |= CastleStatus::BlackQueenside; break;
+			default: throw bad_fen("bad castling rights");
+			}
+		}
+	}
+	state.castle_status = castle_status;
+	state.en_passant_possible = false;
+	state.en_passant_target = BoardPos::A1;
+	if(fields[3] != "-") {
+		const auto& ep = fields[3];
+		if(ep.size() != 2u or ep[0] < 'a' or ep[0] > 'h' or (ep[1] != '3' and ep[1] != '6')) {
+			throw bad_fen("bad en passant target");
+		}
+		state.en_passant_possible = true;
+		state.en_passant_target = board_pos_from_string(ep);
+	}
+	std::size_t halfmove_clock = 0u;
+	std::size_t fullmove_number = 1u;
+	if(field_count == 6u) {
+		auto parse_count = [&](std::string_view sv) {
+			if(sv.empty() or sv.size() > 5u or sv.find_first_not_of("0123456789") != std::string_view::npos) {
+				throw bad_fen("bad move counter");
+			}
+			std::size_t value = 0u;
+			for(char c: sv) {
+				value = value * 10u + static_cast<std::size_t>(c - '0');
+			}
+			return value;
+		};
+		halfmove_clock = parse_count(fields[4]);
+		fullmove_number = parse_count(fields[5]);
+	}
+	state.halfmove_clock = std::min(halfmove_clock, max_halfmove_clock);
+	state.fullmove_number = std::min<std::size_t>(fullmove_number, (std::size_t(1u) << 14u) - 1u);
+	return snapshot;
+}
+
+// Castling rights that are lost when a piece moves from or to 'pos'.
+constexpr CastleStatus castle_rights_lost(BoardPos pos) {
+	switch(pos) {
+	case BoardPos::A1: return CastleStatus::WhiteQueenside;
+	case BoardPos::E1: return CastleStatus::WhiteKingside | CastleStatus::WhiteQueenside;
+	case BoardPos::H1: return CastleStatus::WhiteKingside;
+	case BoardPos::A8: return CastleStatus::BlackQueenside;
+	case BoardPos::E8: return CastleStatus::BlackKingside | CastleStatus::BlackQueenside;
+	case BoardPos::H8: return CastleStatus::BlackKingside;
+	default:           return CastleStatus::None;
+	}
+}
+
+// Advance 'state' past 'mv', a move of 'moved' that captures a piece if 'capture' is set:
+// castling rights, the en passant target, the clocks and the side to move.  The board itself
+// is left to the caller.
+constexpr void advance_temporal_state(TemporalGameState& state, ChessPiece moved, PackedMove mv, bool capture) {
+	auto from = mv.start_position();
+	auto to = mv.end_position();
+	auto moved_kind = kind(moved);
+	bool en_passant_set = false;
+	if(moved_kind == ChessPieceKind::Pawn and (index(row(to)) == index(row(from)) + 2u or index(row(from)) == index(row(to)) + 2u)) {
+		state.en_passant_target = make_board_pos(col(from), row_from_index((index(row(from)) + index(row(to))) / 2u));
+		en_passant_set = true;
+	}
+	state.castle_status = state.castle_status & ~(castle_rights_lost(from) | castle_rights_lost(to));
+	state.en_passant_possible = en_passant_set;
+	if(moved_kind == ChessPieceKind::Pawn or capture) {
+		state.halfmove_clock = 0u;
+	} else if(state.halfmove_clock < max_halfmove_clock) {
+		state.halfmove_clock = state.halfmove_clock + 1u;
+	}
+	if(state.active_color == ChessPieceColor::Black) {
+		state.fullmove_number = state.fullmove_number + 1u;
+		state.active_color = ChessPieceColor::White;
+	} else {
+		state.active_color = ChessPieceColor::Black;
+	}
+}
+
+// Play 'mv' on 'snapshot' and advance its temporal state.  The move must be legal in the
+// position; castling is given as the king's two-square move and en passant as the pawn's
+// diagonal step onto the target square.
+constexpr void apply_move(GameSnapshot& snapshot, PackedMove mv) {
+	auto& board = snapshot.board;
+	auto& state = snapshot.temporal_state;
+	auto from = mv.start_position();
+	auto to = mv.end_position();
+	auto piece = std::as_const(board)[from];
+	assert(piece);
+	assert(color(*piece) == state.active_color);
+	auto captured = std::as_const(board)[to];
+	auto moved_kind = kind(*piece);
+	if(moved_kind == ChessPieceKind::Pawn and col(from) != col(to) and not captured) {
+		assert(state.en_passant_possible and state.en_passant_target == to);
+		auto victim = make_board_pos(col(to), row(from));
+		captured = std::as_const(board)[victim];
+		board[victim] = std::nullopt;
+	} else if(moved_kind == ChessPieceKind::King and (index(col(from)) == index(col(to)) + 2u or index(col(to)) == index(col(from)) + 2u)) {
+		auto kingside = col(to) == 'G'_col;
+		auto rook_from = make_board_pos(kingside ? 'H'_col : 'A'_col, row(from));
+		auto rook_to = make_board_pos(kingside ? 'F'_col : 'D'_col, row(from));
+		board[rook_to] = std::as_const(board)[rook_from];
+		board[rook_from] = std::nullopt;
+	}
+	board[from] = std::nullopt;
+	if(auto promotion = mv.promotion()) {
+		board[to] = color(*piece) + *promotion;
+	} else {
+		board[to] = *piece;
+	}
+	advance_temporal_state(state, *piece, mv, captured.has_value());
+}
+
 inline std::string forsyth_edwards_encoding(const GameSnapshot& snapshot) {
 	return fmt::format(
 		"{} {} {} {} {} {}",
@@ -0,0 +1,186 @@
+#ifndef AC_LATENCY_HISTOGRAM_H
+#define AC_LATENCY_HISTOGRAM_H
+
+#include "portable-snippets/builtin/builtin.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fmt/format.h>
+
+namespace ac {
+
+// Lock-free log-linear histogram of durations in the style of HdrHistogram.  Values below
+// 'sub_bucket_count' nanoseconds get exact buckets; above that, every power of two is split
+// into 'sub_bucket_count / 2' linear buckets, so any recorded value is known to within about
+// 3% across the whole 64-bit range.  Recording is a couple of relaxed atomic increments and
+// may happen concurrently with reads.
+struct LatencyHistogram {
+	static constexpr unsigned sub_bucket_bits      = 5u;
+	static constexpr std::size_t sub_bucket_count  = std::size_t(1u) << sub_bucket_bits;
+	static constexpr std::size_t half_bucket_count = sub_bucket_count / 2u;
+	static constexpr std::size_t bucket_count      = sub_bucket_count + (64u - sub_bucket_bits) * half_bucket_count;
+
+	using duration_type = std::chrono::nanoseconds;
+
+	LatencyHistogram() = default;
+	LatencyHistogram(const LatencyHistogram&) = delete;
+	LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+	static constexpr std::size_t bucket_index(std::uint64_t value) {
+		if(value < sub_bucket_count) {
+			return static_cast<std::size_t>(value);
+		}
+		auto highest_bit = 63u - static_cast<unsigned>(psnip_builtin_clz64(value));
+		auto shift = highest_bit - (sub_bucket_bits - 1u);
+		return sub_bucket_count + (shift - 1u) * half_bucket_count + static_cast<std::size_t>((value >> shift) - half_bucket_count);
+	}
+
+	static constexpr std::uint64_t bucket_lower_bound(std::size_t idx) {
+		if(idx < sub_bucket_count) {
+			return idx;
+		}
+		auto j = idx - sub_bucket_count;
+		auto shift = j / half_bucket_count + 1u;
+		return static_cast<std::uint64_t>(j % half_bucket_count + half_bucket_count) << shift;
+	}
+
+	static constexpr std::uint64_t bucket_upper_bound(std::size_t idx) {
+		if(idx < sub_bucket_count) {
+			return idx;
+		}
+		auto shift = (idx - sub_bucket_count) / half_bucket_count + 1u;
+		return bucket_lower_bound(idx) + ((std::uint64_t(1u) << shift) - 1u);
+	}
+
+	void record(duration_type d) {
+		auto value = static_cast<std::uint64_t>(std::max<duration_type::rep>(d.count(), 0));
+		buckets_[bucket_index(value)].fetch_add(1u, std::memory_order_relaxed);
+		count_.fetch_add(1u, std::memory_order_relaxed);
+		sum_.fetch_add(value, std::memory_order_relaxed);
+		auto prev = max_.load(std::memory_order_relaxed);
+		while(prev < value and not max_.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+			/* LOOP */
+		}
+	}
+
+	std::uint64_t count() const {
+		return count_.load(std::memory_order_relaxed);
+	}
+
+	duration_type max() const {
+		return duration_type(static_cast<duration_type::rep>(max_.load(std::memory_order_relaxed)));
+	}
+
+	duration_type mean() const {
+		auto n = count();
+		if(n == 0u) {
+			return duration_type::zero();
+		}
+		return duration_type(static_cast<duration_type::rep>(sum_.load(std::memory_order_relaxed) / n));
+	}
+
+	// Smallest recorded-bucket upper bound that at least 'fraction' of the samples fall under.
+	duration_type percentile(double fraction) const {
+		auto n = count();
+		if(n == 0u) {
+			return duration_type::zero();
+		}
+		auto target = static_cast<std::uint64_t>(fraction * static_cast<double>(n));
+		target = std::max<std::uint64_t>(target, 1u);
+		std::uint64_t seen = 0u;
+		for(std::size_t i = 0u; i < bucket_count; ++i) {
+			seen += buckets_[i].load(std::memory_order_relaxed);
+			if(seen >= target) {
+				return duration_type(static_cast<duration_type::rep>(std::min(bucket_upper_bound(i), max_.load(std::memory_order_relaxed))));
+			}
+		}
+		return max();
+	}
+
+	// Non-empty buckets as (lower bound in nanoseconds, sample count) pairs.
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> buckets() const {
+		std::vector<std::pair<std::uint64_t, std::uint64_t>> result;
+		for(std::size_t i = 0u; i < bucket_count; ++i) {
+			if(auto n = buckets_[i].load(std::memory_order_relaxed)) {
+				result.emplace_back(bucket_lower_bound(i), n);
+			}
+		}
+		return result;
+	}
+
+	void reset() {
+		for(auto& bucket: buckets_) {
+			bucket.store(0u, std::memory_order_relaxed);
+		}
+		count_.store(0u, std::memory_order_relaxed);
+		sum_.store(0u, std::memory_order_relaxed);
+		max_.store(0u, std::memory_order_relaxed);
+	}
+
+	std::string summary(std::string_view name) const {
+		auto usec = [](duration_type d) { return static_cast<double>(d.count()) / 1000.0; };
+		return fmt::format(
+			"{}: count={} mean={:.1f}us p50={:.1f}us p90={:.1f}us p99={:.1f}us p99.9={:.1f}us max={:.1f}us",
+			name,
+			count(),
+			usec(mean()),
+			usec(percentile(0.5)),
+			usec(percentile(0.9)),
+			usec(percentile(0.99)),
+			usec(percentile(0.999)),
+			usec(max())
+		);
+	}
+
+private:
+	std::array<std::atomic<std::uint64_t>, bucket_count> buckets_ = {};
+	std::atomic<std::uint64_t> count_{0u};
+	std::atomic<std::uint64_t> sum_{0u};
+	std::atomic<std::uint64_t> max_{0u};
+};
+
+static_assert(LatencyHistogram::bucket_index(LatencyHistogram::sub_bucket_count) == LatencyHistogram::sub_bucket_count);
+static_assert(LatencyHistogram::bucket_lower_bound(LatencyHistogram::bucket_index(1000u)) <= 1000u);
+static_assert(LatencyHistogram::bucket_upper_bound(LatencyHistogram::bucket_index(1000u)) >= 1000u);
+static_assert(LatencyHistogram::bucket_index(~std::uint64_t(0u)) == LatencyHistogram::bucket_count - 1u);
+
+// Timings of the engine I/O path, shareable between several engines.
+struct EngineLatencyStats {
+	// 'isready' sent to 'readyok' read.
+	LatencyHistogram isready_to_readyok;
+	// 'go' sent to the first 'info' line read.
+	LatencyHistogram go_to_first_info;
+	// 'go' sent to 'bestmove' read.
+	LatencyHistogram go_to_bestmove;
+	// 'stop' sent to 'bestmove' read.
+	LatencyHistogram stop_to_bestmove;
+	// 'ponderhit' sent to 'bestmove' read.
+	LatencyHistogram ponderhit_to_bestmove;
+	// Time spent in our own parsing of each line the engine sends during a search.
+	LatencyHistogram line_parse;
+
+	std::string report() const {
+		std::string out;
+		for(const auto& [name, hist]: {
+			std::pair<const char*, const LatencyHistogram*>{"isready->readyok", &isready_to_readyok},
+			std::pair<const char*, const LatencyHistogram*>{"go->info", &go_to_first_info},
+			std::pair<const char*, const LatencyHistogram*>{"go->bestmove", &go_to_bestmove},
+			std::pair<const char*, const LatencyHistogram*>{"stop->bestmove", &stop_to_bestmove},
+			std::pair<const char*, const LatencyHistogram*>{"ponderhit->bestmove", &ponderhit_to_bestmove},
+			std::pair<const char*, const LatencyHistogram*>{"parse", &line_parse}
+		}) {
+			out += hist->summary(name);
+			out += '\n';
+		}
+		return out;
+	}
+};
+
+} /* namespace ac */
+
+#endif /* AC_LATENCY_HISTOGRAM_H */
@@ -0,0 +1,184 @@
+#ifndef AC_MATERIAL_SIGNATURE_H
+#define AC_MATERIAL_SIGNATURE_H
+
+#include "BitBoard.h"
+#include "Board.h"
+#include "ChessPiece.h"
+#include "Move.h"
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+namespace ac {
+
+// Piece counts per color and kind, kings left out, packed four bits each into one integer:
+// pawns, knights, bishops, rooks and queens for white in the low 20 bits, then the same for
+// black.  Equal material means equal keys, so the key can route a position (tablebase,
+// engine, book) or filter a database without looking at the board.
+//
+// apply_move()/undo_move() below keep it up to date with a single addition.
+struct MaterialSignature {
+	MaterialSignature() = default;
+
+	static constexpr MaterialSignature from_key(std::uint64_t key) {
+		MaterialSignature sig;
+		sig.key_ = key;
+		return sig;
+	}
+
+	constexpr std::uint64_t key() const {
+		return key_;
+	}
+
+	// Number of 'piece's on the board.  Always 0 for kings, which aren't counted.
+	constexpr std::size_t count(ChessPiece piece) const {
+		if(kind(piece) == ChessPieceKind::King) {
+			return 0u;
+		}
+		return static_cast<std::size_t>((key_ >> shift(piece)) & 0xfu);
+	}
+
+	// Number of pieces on the board, both kings included, as tablebases count them.
+	constexpr std::size_t piece_count() const {
+		std::size_t n = 2u;
+		for(auto k = key_; k != 0u; k >>= 4u) {
+			n += static_cast<std::size_t>(k & 0xfu);
+		}
+		return n;
+	}
+
+	constexpr void add(ChessPiece piece) {
+		key_ += unit(piece);
+	}
+
+	constexpr void remove(ChessPiece piece) {
+		assert(count(piece) > 0u);
+		key_ -= unit(piece);
+	}
+
+	constexpr void adjust(std::uint64_t delta) {
+		key_ += delta;
+	}
+
+	// The same material with the colors swapped.
+	constexpr MaterialSignature mirrored() const {
+		return from_key(((key_ & side_mask) << 20u) | ((key_ >> 20u) & side_mask));
+	}
+
+	friend constexpr bool operator==(MaterialSignature l, MaterialSignature r) {
+		return l.key_ == r.key_;
+	}
+
+	friend constexpr bool operator!=(MaterialSignature l, MaterialSignature r) {
+		return not (l == r);
+	}
+
+	// One addition's worth of 'piece' in the key; kings have none.
+	static constexpr std::uint64_t unit(ChessPiece piece) {
+		return kind(piece) == ChessPieceKind::King ? 0u : std::uint64_t(1u) << shift(piece);
+	}
+
+private:
+	static constexpr std::uint64_t side_mask = (std::uint64_t(1u) << 20u) - 1u;
+
+	static constexpr unsigned shift(ChessPiece piece) {
+		return static_cast<unsigned>(4u * (5u * static_cast<std::size_t>(color(piece)) + static_cast<std::size_t>(kind(piece))));
+	}
+
+	std::uint64_t key_ = 0u;
+};
+
+// Count the material on 'board' from scratch.
+constexpr MaterialSignature material_signature(const Board& board) {
+	MaterialSignature sig;
+	for(std::size_t i = 0u; i < 12u; ++i) {
+		auto piece = chess_piece_from_index(i);
+		sig.adjust(MaterialSignature::unit(piece) * board.positions(piece).count());
+	}
+	return sig;
+}
+
+// Change in the key caused by playing the legal move 'mv' on 'board': a capture removes a
+// piece and a promotion trades a pawn for another piece.  Zero for every other move.
+constexpr std::uint64_t material_delta(const Board& board, PackedMove mv) {
+	auto from = mv.start_position();
+	auto to = mv.end_position();
+	auto piece = board[from];
+	assert(piece);
+	auto c = color(*piece);
+	std::uint64_t delta = 0u;
+	if(auto captured = board[to]) {
+		delta -= MaterialSignature::unit(*captured);
+	} else if(kind(*piece) == ChessPieceKind::Pawn and col(from) != col(to)) {
+		delta -= MaterialSignature::unit(opposite_color(c) + ChessPieceKind::Pawn);
+	}
+	if(auto promotion = mv.promotion()) {
+		delta += MaterialSignature::unit(c + *promotion) - MaterialSignature::unit(c + ChessPieceKind::Pawn);
+	}
+	return delta;
+}
+
+// Update 'material' for 'mv' being played on 'board', the position before the move.
+constexpr void apply_move(MaterialSignature& material, const Board& board, PackedMove mv) {
+	material.adjust(material_delta(board, mv));
+}
+
+// Take 'mv' back out of 'material'.  'board' is again the position before the move.
+constexpr void undo_move(MaterialSignature& material, const Board& board, PackedMove mv) {
+	material.adjust(-material_delta(board, mv));
+}
+
+// Whether neither side can possibly checkmate by material alone: king against king, or
+// against king and a single knight or bishop.  Positions where every bishop stands on the
+// same square color also qualify, but need the board; see the overload below.
+constexpr bool insufficient_material(MaterialSignature material) {
+	auto minor_pieces = [&](ChessPieceColor c) {
+		return material.count(c + ChessPieceKind::Knight) + material.count(c + ChessPieceKind::Bishop);
+	};
+	auto others = [&](ChessPieceColor c) {
+		return material.count(c + ChessPieceKind::Pawn)
+			+ material.count(c + ChessPieceKind::Rook)
+			+ material.count(c + ChessPieceKind::Queen);
+	};
+	if(others(ChessPieceColor::White) != 0u or others(ChessPieceColor::Black) != 0u) {
+		return false;
+	}
+	return minor_pieces(ChessPieceColor::White) + minor_pieces(ChessPieceColor::Black) <= 1u;
+}
+
+// As above, also counting positions with only kings and bishops where all the bishops stand
+// on squares of one color.
+constexpr bool insufficient_material(MaterialSignature material, const Board& board) {
+	if(insufficient_material(material)) {
+		return true;
+	}
+	auto bishops_only = material.count(ChessPieceColor::White + ChessPieceKind::Bishop)
+		+ material.count(ChessPieceColor::Black + ChessPieceKind::Bishop) + 2u == material.piece_count();
+	if(not bishops_only) {
+		return false;
+	}
+	// Squares are indexed column by column, so a1 (dark) is bit 0.
+	constexpr std::uint64_t dark_squares = 0xaa55aa55aa55aa55u;
+	auto bishops = (board.positions(ChessPieceColor::White + ChessPieceKind::Bishop)
+		| board.positions(ChessPieceColor::Black + ChessPieceKind::Bishop)).bits();
+	return (bishops & dark_squares) == 0u or (bishops & ~dark_squares) == 0u;
+}
+
+// The material as conventionally written, stronger pieces first: e.g. "KRPvKR".
+inline std::string material_string(MaterialSignature material) {
+	std::string result;
+	for(auto c: {ChessPieceColor::White, ChessPieceColor::Black}) {
+		if(c == ChessPieceColor::Black) {
+			result += 'v';
+		}
+		result += 'K';
+		for(auto k: {ChessPieceKind::Queen, ChessPieceKind::Rook, ChessPieceKind::Bishop, ChessPieceKind::Knight, ChessPieceKind::Pawn}) {
+			result.append(material.count(c + k), "PNBRQ"[static_cast<std::size_t>(k)]);
+		}
+	}
+	return result;
+}
+
+} /* namespace ac */
+
+#endif /* AC_MATERIAL_SIGNATURE_H */
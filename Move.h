@@ -5,6 +5,10 @@
 #include <optional>
 #include <utility>
 #include <ostream>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
 
 namespace ac {
 
@@ -574,9 +578,7 @@ public:
 		}
 	}
 
-	std::string long_algebraic_notation() const {
-		std::string enc;
-	}
+	std::string long_algebraic_notation() const;
 
 private:
 	constexpr const std::variant<CommonMove, EnPassantMove, CastleMove>& as_variant() const {
@@ -588,6 +590,176 @@ private:
 	}
 };
 
+// Fixed-capacity, NUL-terminated text of a single move.  Long enough for any SAN move
+// ("exd8=Q#" and "Qh4xe1+" are the longest, at 7 characters) or UCI move ("e7e8q").
+struct MoveText {
+	static constexpr std::size_t capacity = 8u;
+
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr bool empty() const {
+		return size_ == 0u;
+	}
+
+	constexpr const char* data() const {
+		return chars_.data();
+	}
+
+	constexpr const char* c_str() const {
+		return chars_.data();
+	}
+
+	constexpr std::string_view view() const {
+		return std::string_view(chars_.data(), size_);
+	}
+
+	constexpr operator std::string_view() const {
+		return view();
+	}
+
+	constexpr void push_back(char c) {
+		assert(size_ + 1u < capacity);
+		chars_[size_++] = c;
+		chars_[size_] = '\0';
+	}
+
+	constexpr void append(std::string_view sv) {
+		for(char c: sv) {
+			push_back(c);
+		}
+	}
+
+	friend constexpr bool operator==(const MoveText& l, std::string_view r) {
+		return l.view() == r;
+	}
+
+	friend constexpr bool operator!=(const MoveText& l, std::string_view r) {
+		return l.view() != r;
+	}
+
+private:
+	std::array<char, capacity> chars_ = {};
+	std::uint8_t size_ = 0u;
+};
+
+// 16-bit encoding of a move as its start square, end square and promotion kind (the same
+// information a UCI move string carries).  Castling is encoded as the king's two-square move.
+struct PackedMove {
+	PackedMove() = default;
+
+	constexpr PackedMove(BoardPos from, BoardPos to, std::optional<ChessPieceKind> promotion = std::nullopt):
+		bits_(static_cast<std::uint16_t>(
+			index(from)
+			| (index(to) << 6u)
+			| ((promotion ? static_cast<unsigned>(*promotion) : 0u) << 12u)
+		))
+	{
+		assert(not promotion or (*promotion != ChessPieceKind::Pawn and *promotion != ChessPieceKind::King));
+	}
+
+	constexpr PackedMove(Move mv):
+		PackedMove(
+			mv.start_position(),
+			mv.end_position(),
+			mv.promotion() ? some(ac::kind(*mv.promotion())) : std::nullopt
+		)
+	{
+		
+	}
+
+	static constexpr PackedMove from_bits(std::uint16_t bits) {
+		PackedMove mv;
+		mv.bits_ = bits;
+		return mv;
+	}
+
+	constexpr std::uint16_t bits() const {
+		return bits_;
+	}
+
+	constexpr BoardPos start_position() const {
+		return board_pos_from_index(bits_ & 0x3Fu);
+	}
+
+	constexpr BoardPos end_position() const {
+		return board_pos_from_index((bits_ >> 6u) & 0x3Fu);
+	}
+
+	constexpr std::optional<ChessPieceKind> promotion() const {
+		auto k = (bits_ >> 12u) & 0x07u;
+		if(k == 0u) {
+			return std::nullopt;
+		}
+		return static_cast<ChessPieceKind>(k);
+	}
+
+	// The all-zero encoding (a1a1) is never a legal move and doubles as "no move".
+	constexpr bool is_null() const {
+		return bits_ == 0u;
+	}
+
+	friend constexpr bool operator==(PackedMove l, PackedMove r) {
+		return l.bits_ == r.bits_;
+	}
+
+	friend constexpr bool operator!=(PackedMove l, PackedMove r) {
+		return l.bits_ != r.bits_;
+	}
+
+private:
+	std::uint16_t bits_ = 0u;
+};
+
+static_assert(sizeof(PackedMove) == 2u);
+
+// UCI long algebraic notation ("e2e4", "e7e8q"); castling is the king's move ("e1g1").
+constexpr MoveText long_algebraic_notation(PackedMove mv) {
+	MoveText text;
+	text.append(name(mv.start_position()));
+	text.append(name(mv.end_position()));
+	if(auto promotion = mv.promotion()) {
+		text.push_back(forsyth_edwards_encoding(ChessPieceColor::Black + *promotion));
+	}
+	return text;
+}
+
+// Parse UCI long algebraic notation without regard to any position; see
+// decode_long_algebraic_notation(const GameSnapshot&, std::string_view) to also check the
+// move is legal.  Returns std::nullopt for malformed input and for the null move "0000".
+constexpr std::optional<PackedMove> decode_long_algebraic_notation(std::string_view lan) {
+	if(lan.size() != 4u and lan.size() != 5u) {
+		return std::nullopt;
+	}
+	auto square = [](char file, char rank) -> std::optional<BoardPos> {
+		if(file < 'a' or file > 'h' or rank < '1' or rank > '8') {
+			return std::nullopt;
+		}
+		return make_board_pos(col_from_index(file - 'a'), row_from_index(rank - '1'));
+	};
+	auto from = square(lan[0], lan[1]);
+	auto to = square(lan[2], lan[3]);
+	if(not from or not to or *from == *to) {
+		return std::nullopt;
+	}
+	std::optional<ChessPieceKind> promotion;
+	if(lan.size() == 5u) {
+		switch(lan[4]) {
+		case 'n': promotion = ChessPieceKind::Knight; break;
+		case 'b': promotion = ChessPieceKind::Bishop; break;
+		case 'r': promotion = ChessPieceKind::Rook;   break;
+		case 'q': promotion = ChessPieceKind::Queen;  break;
+		default:  return std::nullopt;
+		}
+	}
+	return PackedMove(*from, *to, promotion);
+}
+
+inline std::string Move::long_algebraic_notation() const {
+	return std::string(ac::long_algebraic_notation(PackedMove(*this)).view());
+}
+
 } /* namespace ac */
 
 #endif /* AC_MOVE_H */
@@ -0,0 +1,198 @@
+#include "OpeningExplorer.h"
+#include "attack_sets.h"
+#include "Position.h"
+#include "Zobrist.h"
+#include <fmt/format.h>
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+
+namespace ac {
+
+namespace {
+
+using opening_explorer::Entry;
+
+// Raw per-ply entries are folded into the running statistics once there are at least this
+// many of them (or as many as there are statistics already, whichever is more).
+constexpr std::size_t flush_threshold = std::size_t(1u) << 20u;
+
+// 'hash' (the zobrist_hash() of the position) with the en passant target taken out unless a
+// pawn of the side to move can capture onto it.  Otherwise 1. e4 Nf6 2. Nc3 and 1. Nc3 Nf6
+// 2. e4 would reach different keys.
+std::uint64_t explorer_key(std::uint64_t hash, const Board& board, const TemporalGameState& state) {
+	if(state.en_passant_possible) {
+		auto c = state.active_color;
+		auto capturers = pawn_attacks(opposite_color(c), state.en_passant_target) & board.positions(c + ChessPieceKind::Pawn);
+		if(capturers.none()) {
+			hash ^= zobrist_en_passant_key(state.en_passant_target);
+		}
+	}
+	return hash;
+}
+
+bool entry_less(const Entry& l, const Entry& r) {
+	return l.key < r.key or (l.key == r.key and l.move < r.move);
+}
+
+// Sort 'entries' and sum up those for the same position and move.
+void coalesce(std::vector<Entry>& entries) {
+	std::sort(entries.begin(), entries.end(), entry_less);
+	auto out = entries.begin();
+	for(auto it = entries.begin(); it != entries.end(); ++it) {
+		if(out != entries.begin() and std::prev(out)->key == it->key and std::prev(out)->move == it->move) {
+			auto& sum = *std::prev(out);
+			sum.games += it->games;
+			sum.white_wins += it->white_wins;
+			sum.black_wins += it->black_wins;
+			sum.draws += it->draws;
+			sum.rated_games += it->rated_games;
+			sum.rating_sum += it->rating_sum;
+		} else {
+			*out++ = *it;
+		}
+	}
+	entries.erase(out, entries.end());
+}
+
+std::vector<Entry> collect_entries(const GameArchive& games, std::size_t first, std::size_t last, std::size_t max_ply) {
+	std::vector<Entry> stats;
+	std::vector<Entry> pending;
+	auto flush = [&]() {
+		pending.insert(pending.end(), stats.begin(), stats.end());
+		coalesce(pending);
+		stats.swap(pending);
+		pending.clear();
+	};
+	UndoStack undo;
+	for(auto id = first; id < last; ++id) {
+		auto game = games.game(id);
+		const auto& metadata = game.metadata();
+		Position position(game.start_snapshot());
+		undo.clear();
+		auto plies = std::min(game.ply_count(), max_ply);
+		for(std::size_t ply = 0u; ply < plies; ++ply) {
+			auto mv = game[ply];
+			auto rating = position.state.active_color == ChessPieceColor::White ? metadata.white_elo : metadata.black_elo;
+			Entry entry{};
+			entry.key = explorer_key(position.hash, position.board, position.state);
+			entry.move = mv.bits();
+			entry.games = 1u;
+			entry.white_wins = metadata.result == GameResult::WhiteWins;
+			entry.black_wins = metadata.result == GameResult::BlackWins;
+			entry.draws = metadata.result == GameResult::Draw;
+			entry.rated_games = rating != 0u;
+			entry.rating_sum = rating;
+			pending.push_back(entry);
+			make_move(position, mv, undo);
+		}
+		if(pending.size() >= std::max(flush_threshold, stats.size())) {
+			flush();
+		}
+	}
+	flush();
+	return stats;
+}
+
+} /* namespace */
+
+OpeningExplorer::OpeningExplorer(const bfs::path& path):
+	file_(path.string().c_str(), bip::read_only),
+	region_(file_, bip::read_only)
+{
+	auto size = region_.get_size();
+	if(size < sizeof(opening_explorer::FileHeader)) {
+		throw std::runtime_error(fmt::format("Opening explorer '{}' is truncated.", path.string()));
+	}
+	const auto& hdr = header();
+	if(hdr.magic != opening_explorer::magic or hdr.version != opening_explorer::version or hdr.entry_size != sizeof(Entry)) {
+		throw std::runtime_error(fmt::format("'{}' is not an opening explorer file.", path.string()));
+	}
+	if(hdr.entry_count > (size - sizeof(opening_explorer::FileHeader)) / sizeof(Entry)) {
+		throw std::runtime_error(fmt::format("Opening explorer '{}' is truncated.", path.string()));
+	}
+	region_.advise(bip::mapped_region::advice_random);
+}
+
+std::size_t OpeningExplorer::size() const {
+	return header().entry_count;
+}
+
+const opening_explorer::FileHeader& OpeningExplorer::header() const {
+	return *static_cast<const opening_explorer::FileHeader*>(region_.get_address());
+}
+
+const Entry* OpeningExplorer::entries() const {
+	return reinterpret_cast<const Entry*>(static_cast<const char*>(region_.get_address()) + sizeof(opening_explorer::FileHeader));
+}
+
+std::uint64_t opening_explorer_key(const GameSnapshot& snapshot) {
+	return explorer_key(zobrist_hash(snapshot), snapshot.board.decompressed(), snapshot.temporal_state);
+}
+
+std::vector<ExplorerMoveStats> OpeningExplorer::moves(const GameSnapshot& snapshot) const {
+	return moves(opening_explorer_key(snapshot));
+}
+
+std::vector<ExplorerMoveStats> OpeningExplorer::moves(std::uint64_t key) const {
+	auto first = entries();
+	auto last = first + size();
+	auto lower = std::partition_point(first, last, [key](const Entry& e) { return e.key < key; });
+	auto upper = std::partition_point(lower, last, [key](const Entry& e) { return e.key == key; });
+	std::vector<ExplorerMoveStats> result;
+	result.reserve(static_cast<std::size_t>(upper - lower));
+	for(auto it = lower; it != upper; ++it) {
+		ExplorerMoveStats stats;
+		stats.move = PackedMove::from_bits(it->move);
+		stats.games = it->games;
+		stats.white_wins = it->white_wins;
+		stats.black_wins = it->black_wins;
+		stats.draws = it->draws;
+		if(it->rated_games != 0u) {
+			stats.average_rating = static_cast<std::uint16_t>(it->rating_sum / it->rated_games);
+		}
+		result.push_back(stats);
+	}
+	std::stable_sort(result.begin(), result.end(), [](const ExplorerMoveStats& l, const ExplorerMoveStats& r) {
+		return l.games > r.games;
+	});
+	return result;
+}
+
+void build_opening_explorer(const GameArchive& games, const bfs::path& path, const OpeningExplorerOptions& options) {
+	auto max_ply = std::min(options.max_ply, UndoStack::capacity);
+	auto thread_count = std::max<std::size_t>(1u, std::min(options.thread_count, games.size()));
+	// Each thread takes a contiguous run of games.
+	std::vector<std::future<std::vector<Entry>>> parts;
+	for(std::size_t t = 0u; t < thread_count; ++t) {
+		auto first = games.size() * t / thread_count;
+		auto last = games.size() * (t + 1u) / thread_count;
+		parts.push_back(std::async(std::launch::async, collect_entries, std::cref(games), first, last, max_ply));
+	}
+	std::vector<Entry> entries;
+	for(auto& part: parts) {
+		auto stats = part.get();
+		entries.insert(entries.end(), stats.begin(), stats.end());
+	}
+	coalesce(entries);
+
+	std::ofstream out(path.string(), std::ios::binary | std::ios::trunc);
+	if(not out) {
+		throw std::runtime_error(fmt::format("Failed to create opening explorer '{}'.", path.string()));
+	}
+	out.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+	opening_explorer::FileHeader header{
+		opening_explorer::magic,
+		opening_explorer::version,
+		static_cast<std::uint32_t>(sizeof(Entry)),
+		static_cast<std::uint64_t>(entries.size())
+	};
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+	out.close();
+}
+
+} /* namespace ac */
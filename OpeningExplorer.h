@@ -0,0 +1,110 @@
+#ifndef AC_OPENING_EXPLORER_H
+#define AC_OPENING_EXPLORER_H
+
+#include "GameArchive.h"
+#include "GameSnapshot.h"
+#include "Move.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem/path.hpp>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ac {
+
+namespace bip = boost::interprocess;
+namespace bfs = boost::filesystem;
+
+// How often a move was played from a position, and how those games ended.
+struct ExplorerMoveStats {
+	PackedMove move;
+	std::size_t games       = 0u;
+	std::size_t white_wins  = 0u;
+	std::size_t black_wins  = 0u;
+	std::size_t draws       = 0u;
+	// Mean rating of the players who made the move, over the games where it is known.
+	std::optional<std::uint16_t> average_rating = std::nullopt;
+};
+
+// File layout: a header followed by the entries, sorted by position key and then move, so a
+// position's moves are adjacent and found by binary search.  Positions are keyed by
+// opening_explorer_key().
+//
+// Like the game archive, the file uses the host's byte order and struct layout.
+namespace opening_explorer {
+
+struct FileHeader {
+	std::array<char, 8u> magic;
+	std::uint32_t version;
+	std::uint32_t entry_size;
+	std::uint64_t entry_count;
+};
+
+struct Entry {
+	std::uint64_t key;
+	std::uint16_t move;
+	std::uint16_t reserved;
+	std::uint32_t games;
+	std::uint32_t white_wins;
+	std::uint32_t black_wins;
+	std::uint32_t draws;
+	// Games where the mover's rating is known, and the sum of those ratings.
+	std::uint32_t rated_games;
+	std::uint64_t rating_sum;
+};
+
+inline constexpr std::array<char, 8u> magic = {'A', 'C', 'O', 'P', 'E', 'N', 'E', 'X'};
+inline constexpr std::uint32_t version = 2u;
+
+static_assert(std::is_trivially_copyable_v<FileHeader>);
+static_assert(std::is_trivially_copyable_v<Entry>);
+
+} /* namespace opening_explorer */
+
+struct OpeningExplorerOptions {
+	// Only the first this many plies of each game are indexed.
+	std::size_t max_ply      = 40u;
+	// Number of threads replaying games.
+	std::size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+};
+
+// Key of 'snapshot' in an opening explorer: its zobrist_hash(), except that an en passant
+// target counts only if a pawn of the side to move can capture onto it, as in Polyglot books.
+std::uint64_t opening_explorer_key(const GameSnapshot& snapshot);
+
+// Read-only opening explorer: what was played from a position across an archive of games.
+struct OpeningExplorer {
+	explicit OpeningExplorer(const bfs::path& path);
+
+	OpeningExplorer(const OpeningExplorer&) = delete;
+	OpeningExplorer& operator=(const OpeningExplorer&) = delete;
+
+	// Number of distinct (position, move) pairs.
+	std::size_t size() const;
+
+	// The moves played from 'snapshot', most played first.  Empty if the position never
+	// occurred within the indexed plies.
+	std::vector<ExplorerMoveStats> moves(const GameSnapshot& snapshot) const;
+	// As above, by opening_explorer_key().
+	std::vector<ExplorerMoveStats> moves(std::uint64_t key) const;
+
+private:
+	const opening_explorer::FileHeader& header() const;
+	const opening_explorer::Entry* entries() const;
+
+	bip::file_mapping file_;
+	bip::mapped_region region_;
+};
+
+// Replay the opening of every game of 'games' and write the explorer index to 'path'.  The
+// archive is split among 'options.thread_count' threads, whose statistics are merged at the
+// end.
+void build_opening_explorer(const GameArchive& games, const bfs::path& path, const OpeningExplorerOptions& options = OpeningExplorerOptions());
+
+} /* namespace ac */
+
+#endif /* AC_OPENING_EXPLORER_H */
@@ -0,0 +1,367 @@
+#include "PGNImporter.h"
+#include "algebraic_notation.h"
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <fmt/format.h>
+#include <deque>
+#include <future>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace ac {
+
+namespace {
+
+bool is_pgn_space(char c) {
+	return c == ' ' or c == '\t' or c == '\r' or c == '\n';
+}
+
+// Whether the last non-blank line before 'pos' is a tag pair.
+bool follows_tag_pair(std::string_view text, std::size_t pos) {
+	while(pos > 0u and is_pgn_space(text[pos - 1u])) {
+		--pos;
+	}
+	if(pos == 0u) {
+		return false;
+	}
+	auto line_start = text.rfind('\n', pos - 1u);
+	return text[line_start == std::string_view::npos ? 0u : line_start + 1u] == '[';
+}
+
+// Offset of the first game that starts at or after 'from', or text.size() if there is none.
+// A game starts with the first line of a tag section: a line starting with '[' that doesn't
+// directly follow another tag pair.  Not every exporter writes an 'Event' tag first.
+std::size_t next_game_start(std::string_view text, std::size_t from) {
+	while(from < text.size()) {
+		auto pos = text.find('[', from);
+		if(pos == std::string_view::npos) {
+			break;
+		}
+		if((pos == 0u or text[pos - 1u] == '\n') and not follows_tag_pair(text, pos)) {
+			return pos;
+		}
+		from = pos + 1u;
+	}
+	return text.size();
+}
+
+std::size_t skip_line(std::string_view text, std::size_t pos) {
+	auto stop = text.find('\n', pos);
+	return stop == std::string_view::npos ? text.size() : stop + 1u;
+}
+
+std::size_t skip_comment(std::string_view text, std::size_t pos) {
+	assert(text[pos] == '{');
+	auto stop = text.find('}', pos);
+	if(stop == std::string_view::npos) {
+		throw std::runtime_error("Unterminated comment.");
+	}
+	return stop + 1u;
+}
+
+// Skip a (possibly nested) variation, including any comments inside it.
+std::size_t skip_variation(std::string_view text, std::size_t pos) {
+	assert(text[pos] == '(');
+	std::size_t depth = 0u;
+	while(pos < text.size()) {
+		switch(text[pos]) {
+		case '(':
+			++depth;
+			++pos;
+			break;
+		case ')':
+			++pos;
+			if(--depth == 0u) {
+				return pos;
+			}
+			break;
+		case '{':
+			pos = skip_comment(text, pos);
+			break;
+		case ';':
+			pos = skip_line(text, pos);
+			break;
+		default:
+			++pos;
+		}
+	}
+	throw std::runtime_error("Unterminated variation.");
+}
+
+std::optional<GameResult> parse_result(std::string_view sv) {
+	if(sv == "1-0") {
+		return GameResult::WhiteWins;
+	} else if(sv == "0-1") {
+		return GameResult::BlackWins;
+	} else if(sv == "1/2-1/2") {
+		return GameResult::Draw;
+	} else if(sv == "*") {
+		return GameResult::Unknown;
+	}
+	return std::nullopt;
+}
+
+std::uint16_t parse_elo(std::string_view sv) {
+	if(sv.empty() or sv.size() > 5u or sv.find_first_not_of("0123456789") != std::string_view::npos) {
+		return 0u;
+	}
+	std::size_t value = 0u;
+	for(char c: sv) {
+		value = value * 10u + static_cast<std::size_t>(c - '0');
+	}
+	return static_cast<std::uint16_t>(std::min<std::size_t>(value, std::numeric_limits<std::uint16_t>::max()));
+}
+
+struct TagPair {
+	std::string_view name;
+	std::string_view value;
+};
+
+// Parse '[Name "Value"]' starting at 'pos'.  Escapes in the value are left as they are; none of
+// the tags we read can contain them.
+TagPair parse_tag(std::string_view text, std::size_t& pos) {
+	assert(text[pos] == '[');
+	auto bad_tag = [&]() {
+		return std::runtime_error(fmt::format("Bad tag pair: '{}'", text.substr(pos, skip_line(text, pos) - pos)));
+	};
+	auto i = pos + 1u;
+	auto name_start = i;
+	while(i < text.size() and not is_pgn_space(text[i]) and text[i] != '"') {
+		++i;
+	}
+	TagPair tag;
+	tag.name = text.substr(name_start, i - name_start);
+	while(i < text.size() and (text[i] == ' ' or text[i] == '\t')) {
+		++i;
+	}
+	if(tag.name.empty() or i >= text.size() or text[i] != '"') {
+		throw bad_tag();
+	}
+	auto value_start = ++i;
+	while(i < text.size() and text[i] != '"') {
+		i += text[i] == '\\' ? 2u : 1u;
+	}
+	if(i >= text.size()) {
+		throw bad_tag();
+	}
+	tag.value = text.substr(value_start, i - value_start);
+	++i;
+	while(i < text.size() and (text[i] == ' ' or text[i] == '\t')) {
+		++i;
+	}
+	if(i >= text.size() or text[i] != ']') {
+		throw bad_tag();
+	}
+	pos = i + 1u;
+	return tag;
+}
+
+// Parse the game starting at 'pos', leaving 'pos' just past its termination marker (or at the
+// end of 'text' if it has none).
+PGNGame parse_game_at(std::string_view text, std::size_t& pos) {
+	GameMetadata metadata;
+	std::string_view fen;
+	for(;;) {
+		while(pos < text.size() and is_pgn_space(text[pos])) {
+			++pos;
+		}
+		if(pos >= text.size() or text[pos] != '[') {
+			break;
+		}
+		auto tag = parse_tag(text, pos);
+		if(tag.name == "FEN") {
+			fen = tag.value;
+		} else if(tag.name == "Result") {
+			metadata.result = parse_result(tag.value).value_or(GameResult::Unknown);
+		} else if(tag.name == "WhiteElo") {
+			metadata.white_elo = parse_elo(tag.value);
+		} else if(tag.name == "BlackElo") {
+			metadata.black_elo = parse_elo(tag.value);
+		}
+	}
+	GameHistory history(GameSnapshot::decode_fen_string(fen.empty() ? standard_starting_fen : fen));
+	while(pos < text.size()) {
+		auto c = text[pos];
+		if(is_pgn_space(c)) {
+			++pos;
+			continue;
+		}
+		switch(c) {
+		case '{':
+			pos = skip_comment(text, pos);
+			continue;
+		case ';':
+			pos = skip_line(text, pos);
+			continue;
+		case '(':
+			pos = skip_variation(text, pos);
+			continue;
+		case '$':
+			for(++pos; pos < text.size() and text[pos] >= '0' and text[pos] <= '9'; ++pos) {
+				// NAG
+			}
+			continue;
+		case '%':
+			if(pos == 0u or text[pos - 1u] == '\n') {
+				// Escaped line.
+				pos = skip_line(text, pos);
+				continue;
+			}
+			break;
+		case ')':
+			throw std::runtime_error("Unbalanced ')' in movetext.");
+		case '[':
+			throw std::runtime_error("Tag pair inside movetext.");
+		}
+		auto stop = std::min(text.find_first_of(" \t\r\n{}();$", pos), text.size());
+		auto token = text.substr(pos, stop - pos);
+		pos = stop;
+		if(auto result = parse_result(token)) {
+			// Game termination marker; it wins over a missing or '*' Result tag.
+			if(metadata.result == GameResult::Unknown) {
+				metadata.result = *result;
+			}
+			break;
+		}
+		// Move number indication ("12." or "12..."), possibly run together with the move.
+		auto digits = token.find_first_not_of("0123456789");
+		if(digits == std::string_view::npos) {
+			continue;
+		}
+		if(digits != 0u and token[digits] == '.') {
+			token.remove_prefix(std::min(token.find_first_not_of('.', digits), token.size()));
+			if(token.empty()) {
+				continue;
+			}
+		}
+		auto mv = decode_standard_algebraic_notation(history.current_snapshot(), token);
+		if(not mv) {
+			throw std::runtime_error(fmt::format(
+				"Illegal or ambiguous move '{}' in position '{}'.",
+				token,
+				forsyth_edwards_encoding(history.current_snapshot())
+			));
+		}
+		history.push_back(*mv);
+	}
+	return PGNGame{std::move(history), metadata};
+}
+
+struct BatchResult {
+	std::vector<PGNGame> games;
+	// Byte offset in the file and the reason for each game that was skipped.
+	std::vector<std::pair<std::size_t, std::string>> errors;
+};
+
+BatchResult parse_batch(std::string_view text, std::size_t offset) {
+	BatchResult result;
+	std::size_t start = 0u;
+	while(start < text.size()) {
+		auto stop = next_game_start(text, start + 1u);
+		// Games without tag pairs follow one another with only a termination marker between
+		// them, so a section may hold several.
+		auto section = text.substr(start, stop - start);
+		std::size_t pos = 0u;
+		while(section.find_first_not_of(" \t\r\n", pos) != std::string_view::npos) {
+			auto game_start = pos;
+			try {
+				result.games.push_back(parse_game_at(section, pos));
+			} catch(const std::runtime_error& e) {
+				// No telling where the broken game ends; resume at the next tag section.
+				result.errors.emplace_back(offset + start + game_start, e.what());
+				break;
+			}
+		}
+		start = stop;
+	}
+	return result;
+}
+
+} /* namespace */
+
+PGNGame parse_pgn_game(std::string_view text) {
+	std::size_t pos = 0u;
+	auto game = parse_game_at(text, pos);
+	auto rest = text.find_first_not_of(" \t\r\n", pos);
+	if(rest != std::string_view::npos) {
+		throw std::runtime_error(fmt::format(
+			"Text after the game termination marker: '{}'",
+			text.substr(rest, skip_line(text, rest) - rest)
+		));
+	}
+	return game;
+}
+
+PGNImportStats import_pgn(
+	const bfs::path& path,
+	const std::function<void(PGNGame&&)>& on_game,
+	const PGNImportOptions& options,
+	const std::function<void(std::size_t, const std::string&)>& on_error
+) {
+	PGNImportStats stats;
+	if(bfs::file_size(path) == 0u) {
+		// Empty files can't be mapped.
+		return stats;
+	}
+	bip::file_mapping file(path.string().c_str(), bip::read_only);
+	bip::mapped_region region(file, bip::read_only);
+	region.advise(bip::mapped_region::advice_sequential);
+	std::string_view text(static_cast<const char*>(region.get_address()), region.get_size());
+
+	std::size_t start = 0u;
+	if(text.substr(0u, 3u) == "\xEF\xBB\xBF") {
+		// UTF-8 byte order mark.
+		start = 3u;
+	}
+	auto thread_count = std::max<std::size_t>(options.thread_count, 1u);
+	auto batch_bytes = std::max<std::size_t>(options.batch_bytes, 1u);
+	// Batches are delivered in the order they were started, so games come out in file order.
+	std::deque<std::future<BatchResult>> in_flight;
+	auto deliver_oldest = [&]() {
+		auto result = in_flight.front().get();
+		in_flight.pop_front();
+		for(auto& game: result.games) {
+			on_game(std::move(game));
+			++stats.games_imported;
+		}
+		for(const auto& [offset, what]: result.errors) {
+			++stats.games_skipped;
+			if(on_error) {
+				on_error(offset, what);
+			}
+		}
+	};
+	while(start < text.size()) {
+		auto stop = next_game_start(text, std::min(text.size(), start + batch_bytes));
+		in_flight.push_back(std::async(std::launch::async, parse_batch, text.substr(start, stop - start), start));
+		start = stop;
+		if(in_flight.size() >= thread_count) {
+			deliver_oldest();
+		}
+	}
+	while(not in_flight.empty()) {
+		deliver_oldest();
+	}
+	return stats;
+}
+
+PGNImportStats import_pgn(
+	const bfs::path& path,
+	GameArchiveWriter& archive,
+	const PGNImportOptions& options,
+	const std::function<void(std::size_t, const std::string&)>& on_error
+) {
+	return import_pgn(
+		path,
+		[&](PGNGame&& game) {
+			archive.append(game.history, game.metadata);
+		},
+		options,
+		on_error
+	);
+}
+
+} /* namespace ac */
@@ -0,0 +1,61 @@
+#ifndef AC_PGN_IMPORTER_H
+#define AC_PGN_IMPORTER_H
+
+#include "GameArchive.h"
+#include "GameHistory.h"
+#include "GameSnapshot.h"
+#include <boost/filesystem/path.hpp>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace ac {
+
+struct PGNGame {
+	GameHistory history;
+	GameMetadata metadata;
+};
+
+struct PGNImportOptions {
+	// Number of games parsed concurrently.
+	std::size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+	// Games are handed to the workers in batches of roughly this many bytes of PGN text.
+	std::size_t batch_bytes  = std::size_t(1u) << 20u;
+};
+
+struct PGNImportStats {
+	std::size_t games_imported = 0u;
+	std::size_t games_skipped  = 0u;
+};
+
+// Parse the text of a single game: its tag pairs followed by its movetext.  Comments,
+// NAGs and variations are skipped; every mainline move is checked against the legal moves of
+// the position it is played in.  Throws std::runtime_error on malformed or illegal input,
+// including anything but whitespace after the game termination marker.
+PGNGame parse_pgn_game(std::string_view text);
+
+// Import every game of a PGN file.  The file is memory-mapped and split into batches at game
+// boundaries (the first line of a tag section), and the batches are parsed on
+// 'options.thread_count' threads.  Games without tag pairs are split at their termination
+// markers.  'on_game' is called on the calling thread, in file order.
+// A game that fails to parse is skipped and reported to 'on_error' (if given) along with its
+// byte offset in the file.
+PGNImportStats import_pgn(
+	const bfs::path& path,
+	const std::function<void(PGNGame&&)>& on_game,
+	const PGNImportOptions& options = PGNImportOptions(),
+	const std::function<void(std::size_t, const std::string&)>& on_error = {}
+);
+
+// Import every game of a PGN file into 'archive', in file order.
+PGNImportStats import_pgn(
+	const bfs::path& path,
+	GameArchiveWriter& archive,
+	const PGNImportOptions& options = PGNImportOptions(),
+	const std::function<void(std::size_t, const std::string&)>& on_error = {}
+);
+
+} /* namespace ac */
+
+#endif /* AC_PGN_IMPORTER_H */
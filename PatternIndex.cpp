@@ -0,0 +1,161 @@
+#include "PatternIndex.h"
+#include "attack_sets.h"
+#include <fmt/format.h>
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace ac {
+
+PatternIndex::PatternIndex(const bfs::path& path):
+	file_(path.string().c_str(), bip::read_only),
+	region_(file_, bip::read_only)
+{
+	auto size = region_.get_size();
+	constexpr auto offsets_size = (pattern_index::key_count + 1u) * sizeof(std::uint64_t);
+	if(size < sizeof(pattern_index::FileHeader) + offsets_size) {
+		throw std::runtime_error(fmt::format("Pattern index '{}' is truncated.", path.string()));
+	}
+	const auto& hdr = header();
+	if(hdr.magic != pattern_index::magic or hdr.version != pattern_index::version) {
+		throw std::runtime_error(fmt::format("'{}' is not a pattern index.", path.string()));
+	}
+	const auto* offs = offsets();
+	auto posting_count = (size - sizeof(pattern_index::FileHeader) - offsets_size) / sizeof(std::uint32_t);
+	if(offs[0] != 0u
+		or not std::is_sorted(offs, offs + pattern_index::key_count + 1u)
+		or offs[pattern_index::key_count] > posting_count)
+	{
+		throw std::runtime_error(fmt::format("Pattern index '{}' has corrupt offsets.", path.string()));
+	}
+}
+
+std::size_t PatternIndex::size() const {
+	return header().game_count;
+}
+
+const pattern_index::FileHeader& PatternIndex::header() const {
+	return *static_cast<const pattern_index::FileHeader*>(region_.get_address());
+}
+
+const std::uint64_t* PatternIndex::offsets() const {
+	return reinterpret_cast<const std::uint64_t*>(static_cast<const char*>(region_.get_address()) + sizeof(pattern_index::FileHeader));
+}
+
+const std::uint32_t* PatternIndex::postings() const {
+	return reinterpret_cast<const std::uint32_t*>(offsets() + pattern_index::key_count + 1u);
+}
+
+std::vector<std::uint32_t> PatternIndex::candidates(const PiecePattern& pattern) const {
+	using posting_list = std::pair<const std::uint32_t*, const std::uint32_t*>;
+	std::vector<posting_list> lists;
+	const auto* offs = offsets();
+	for(std::size_t i = 0u; i < 12u; ++i) {
+		for(auto pos: pattern.squares[i].positions()) {
+			auto key = i * 64u + index(pos);
+			lists.emplace_back(postings() + offs[key], postings() + offs[key + 1u]);
+		}
+	}
+	std::vector<std::uint32_t> result;
+	if(lists.empty()) {
+		result.resize(size());
+		std::iota(result.begin(), result.end(), std::uint32_t(0u));
+		return result;
+	}
+	// Start from the shortest list; every other list is only searched for the survivors.
+	std::sort(lists.begin(), lists.end(), [](const posting_list& l, const posting_list& r) {
+		return (l.second - l.first) < (r.second - r.first);
+	});
+	result.assign(lists.front().first, lists.front().second);
+	for(auto it = lists.begin() + 1; it != lists.end() and not result.empty(); ++it) {
+		auto [first, last] = *it;
+		auto kept = result.begin();
+		for(auto id: result) {
+			first = std::lower_bound(first, last, id);
+			if(first == last) {
+				break;
+			}
+			if(*first == id) {
+				*kept++ = id;
+			}
+		}
+		result.erase(kept, result.end());
+	}
+	return result;
+}
+
+std::vector<PatternMatch> PatternIndex::find(const GameArchive& games, const PiecePattern& pattern, std::size_t limit) const {
+	if(games.size() != size()) {
+		throw std::runtime_error(fmt::format(
+			"Pattern index covers {} games but the archive holds {}.", size(), games.size()
+		));
+	}
+	std::vector<PatternMatch> matches;
+	for(auto id: candidates(pattern)) {
+		if(matches.size() >= limit) {
+			break;
+		}
+		auto game = games.game(id);
+		auto board = game.start_snapshot().board.decompressed();
+		if(pattern.matches(board)) {
+			matches.push_back(PatternMatch{id, 0u});
+			continue;
+		}
+		for(std::size_t ply = 0u; ply < game.ply_count(); ++ply) {
+			board = board_after(board, game[ply]);
+			if(pattern.matches(board)) {
+				matches.push_back(PatternMatch{id, ply + 1u});
+				break;
+			}
+		}
+	}
+	return matches;
+}
+
+void build_pattern_index(const GameArchive& games, const bfs::path& path) {
+	if(games.size() > std::numeric_limits<std::uint32_t>::max()) {
+		throw std::runtime_error(fmt::format("Too many games ({}) for a pattern index.", games.size()));
+	}
+	std::vector<std::vector<std::uint32_t>> lists(pattern_index::key_count);
+	for(std::size_t id = 0u; id < games.size(); ++id) {
+		auto game = games.game(id);
+		auto board = game.start_snapshot().board.decompressed();
+		// Every square each piece stood on during the game.
+		std::array<std::uint64_t, 12u> visited = {};
+		auto visit = [&]() {
+			for(std::size_t i = 0u; i < 12u; ++i) {
+				visited[i] |= board.positions(chess_piece_from_index(i)).bits();
+			}
+		};
+		visit();
+		for(auto mv: game) {
+			board = board_after(board, mv);
+			visit();
+		}
+		for(std::size_t i = 0u; i < 12u; ++i) {
+			for(auto pos: BitBoard::from_bits(visited[i]).positions()) {
+				lists[i * 64u + index(pos)].push_back(static_cast<std::uint32_t>(id));
+			}
+		}
+	}
+	std::ofstream out(path.string(), std::ios::binary | std::ios::trunc);
+	if(not out) {
+		throw std::runtime_error(fmt::format("Failed to create pattern index '{}'.", path.string()));
+	}
+	out.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+	pattern_index::FileHeader header{pattern_index::magic, pattern_index::version, 0u, static_cast<std::uint64_t>(games.size())};
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	std::vector<std::uint64_t> offsets(pattern_index::key_count + 1u, 0u);
+	for(std::size_t key = 0u; key < pattern_index::key_count; ++key) {
+		offsets[key + 1u] = offsets[key] + lists[key].size();
+	}
+	out.write(reinterpret_cast<const char*>(offsets.data()), static_cast<std::streamsize>(offsets.size() * sizeof(std::uint64_t)));
+	for(const auto& list: lists) {
+		out.write(reinterpret_cast<const char*>(list.data()), static_cast<std::streamsize>(list.size() * sizeof(std::uint32_t)));
+	}
+	out.close();
+}
+
+} /* namespace ac */
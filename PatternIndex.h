@@ -0,0 +1,118 @@
+#ifndef AC_PATTERN_INDEX_H
+#define AC_PATTERN_INDEX_H
+
+#include "BitBoard.h"
+#include "Board.h"
+#include "ChessPiece.h"
+#include "GameArchive.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem/path.hpp>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace ac {
+
+namespace bip = boost::interprocess;
+namespace bfs = boost::filesystem;
+
+// Pieces required on given squares, e.g. a white knight on f5 and a black king on g8 behind
+// pawns on f7, g7 and h7:
+//
+//	PiecePattern()
+//		.require(ChessPieceColor::White + ChessPieceKind::Knight, make_board_pos('F'_col, 5_row))
+//		.require(ChessPieceColor::Black + ChessPieceKind::King, make_board_pos('G'_col, 8_row))
+//		...
+//
+// Squares the pattern doesn't mention may hold anything.
+struct PiecePattern {
+	// Indexed by index(ChessPiece).
+	std::array<BitBoard, 12u> squares = {};
+
+	PiecePattern& require(ChessPiece piece, BoardPos pos) {
+		auto& bits = squares[index(piece)];
+		bits = BitBoard::from_bits(bits.bits() | (std::uint64_t(1u) << index(pos)));
+		return *this;
+	}
+
+	bool matches(const Board& board) const {
+		for(std::size_t i = 0u; i < 12u; ++i) {
+			if((board.positions(chess_piece_from_index(i)) & squares[i]) != squares[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+struct PatternMatch {
+	std::size_t game;
+	// Number of moves played before the matching position; 0 is the start position.
+	std::size_t ply;
+};
+
+// File layout: a header, then 'key_count + 1' postings offsets and the postings themselves.
+// The postings of key 'k' (piece index * 64 + square index) are the ids, in increasing order,
+// of the games in which that piece stands on that square at some point; they are
+// 'postings[offsets[k]]' up to 'postings[offsets[k + 1]]'.
+//
+// Like the game archive, the file uses the host's byte order and struct layout.
+namespace pattern_index {
+
+struct FileHeader {
+	std::array<char, 8u> magic;
+	std::uint32_t version;
+	std::uint32_t reserved;
+	std::uint64_t game_count;
+};
+
+inline constexpr std::array<char, 8u> magic = {'A', 'C', 'P', 'A', 'T', 'I', 'D', 'X'};
+inline constexpr std::uint32_t version = 1u;
+inline constexpr std::size_t key_count = 12u * 64u;
+
+static_assert(std::is_trivially_copyable_v<FileHeader>);
+
+} /* namespace pattern_index */
+
+// Read-only index over a game archive for piece placement queries.  A query only replays the
+// games whose postings contain every square of the pattern, so its cost grows with the number
+// of candidate games rather than the size of the archive.
+struct PatternIndex {
+	explicit PatternIndex(const bfs::path& path);
+
+	PatternIndex(const PatternIndex&) = delete;
+	PatternIndex& operator=(const PatternIndex&) = delete;
+
+	// Number of games in the indexed archive.
+	std::size_t size() const;
+
+	// Ids of the games in which every piece of 'pattern' stands on its square at some point,
+	// though not necessarily all at once.  A pattern with no squares selects every game.
+	std::vector<std::uint32_t> candidates(const PiecePattern& pattern) const;
+
+	// The first position matching 'pattern' in each game of 'games' (the archive the index was
+	// built from) that has one, in game order, stopping after 'limit' matches.
+	std::vector<PatternMatch> find(
+		const GameArchive& games,
+		const PiecePattern& pattern,
+		std::size_t limit = std::numeric_limits<std::size_t>::max()
+	) const;
+
+private:
+	const pattern_index::FileHeader& header() const;
+	const std::uint64_t* offsets() const;
+	const std::uint32_t* postings() const;
+
+	bip::file_mapping file_;
+	bip::mapped_region region_;
+};
+
+// Replay every game of 'games' and write its pattern index to 'path'.
+void build_pattern_index(const GameArchive& games, const bfs::path& path);
+
+} /* namespace ac */
+
+#endif /* AC_PATTERN_INDEX_H */
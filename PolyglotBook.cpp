@@ -0,0 +1,224 @@
+#include "PolyglotBook.h"
+#include <fmt/format.h>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace ac {
+
+namespace {
+
+// Polyglot's 781 'Random64' keys: 768 for pieces on squares, 4 for castling rights, 8 for
+// en passant files and 1 for white to move.  The literals come from polyglot_random64.inc,
+// set up by CMake from AC_POLYGLOT_RANDOM64.
+#if !__has_include("polyglot_random64.inc")
+#error "polyglot_random64.inc not found; point AC_POLYGLOT_RANDOM64 at Polyglot's Random64 table."
+#endif
+constexpr std::uint64_t random64[] = {
+#include "polyglot_random64.inc"
+};
+
+static_assert(std::size(random64) == 781u, "Polyglot's Random64 table has 781 keys.");
+
+// Offsets into the Random64 table.
+constexpr std::size_t castle_key_offset     = 768u;
+constexpr std::size_t en_passant_key_offset = 772u;
+constexpr std::size_t turn_key_offset       = 780u;
+
+constexpr std::size_t piece_key_offset(ChessPiece piece, BoardPos pos) {
+	// Polyglot orders pieces black pawn, white pawn, black knight, ... white king.
+	auto kind_index = static_cast<std::size_t>(kind(piece));
+	auto is_white = color(piece) == ChessPieceColor::White ? 1u : 0u;
+	return 64u * (2u * kind_index + is_white) + 8u * index(row(pos)) + index(col(pos));
+}
+
+// Key of the standard starting position, built up piece by piece.
+constexpr std::uint64_t starting_position_key() {
+	constexpr ChessPieceKind back_rank[8u] = {
+		ChessPieceKind::Rook,
+		ChessPieceKind::Knight,
+		ChessPieceKind::Bishop,
+		ChessPieceKind::Queen,
+		ChessPieceKind::King,
+		ChessPieceKind::Bishop,
+		ChessPieceKind::Knight,
+		ChessPieceKind::Rook
+	};
+	std::uint64_t key = 0u;
+	for(std::size_t i = 0u; i < 8u; ++i) {
+		auto c = col_from_index(i);
+		key ^= random64[piece_key_offset(ChessPieceColor::White + back_rank[i], make_board_pos(c, 1_row))];
+		key ^= random64[piece_key_offset(ChessPieceColor::White + ChessPieceKind::Pawn, make_board_pos(c, 2_row))];
+		key ^= random64[piece_key_offset(ChessPieceColor::Black + ChessPieceKind::Pawn, make_board_pos(c, 7_row))];
+		key ^= random64[piece_key_offset(ChessPieceColor::Black + back_rank[i], make_board_pos(c, 8_row))];
+	}
+	for(std::size_t i = 0u; i < 4u; ++i) {
+		key ^= random64[castle_key_offset + i];
+	}
+	return key ^ random64[turn_key_offset];
+}
+
+// The format description publishes this key for the starting position.
+static_assert(starting_position_key() == 0x463B96181691FC9Cu, "polyglot_random64.inc is not Polyglot's Random64 table.");
+
+template <std::size_t N>
+std::uint64_t read_big_endian(const unsigned char* p) {
+	std::uint64_t value = 0u;
+	for(std::size_t i = 0u; i < N; ++i) {
+		value = (value << 8u) | p[i];
+	}
+	return value;
+}
+
+} /* namespace */
+
+std::uint64_t polyglot_hash(const GameSnapshot& snapshot) {
+	const auto& state = snapshot.temporal_state;
+	auto board = snapshot.board.decompressed();
+	std::uint64_t key = 0u;
+	for(auto pos: board.all_positions().positions()) {
+		key ^= random64[piece_key_offset(*board[pos], pos)];
+	}
+	constexpr CastleStatus castle_flags[4u] = {
+		CastleStatus::WhiteKingside,
+		CastleStatus::WhiteQueenside,
+		CastleStatus::BlackKingside,
+		CastleStatus::BlackQueenside
+	};
+	for(std::size_t i = 0u; i < 4u; ++i) {
+		if((state.castle_status & castle_flags[i]) != CastleStatus::None) {
+			key ^= random64[castle_key_offset + i];
+		}
+	}
+	if(state.en_passant_possible) {
+		auto c = state.active_color;
+		auto capturers = pawn_attacks(opposite_color(c), state.en_passant_target) & board.positions(c + ChessPieceKind::Pawn);
+		if(capturers.any()) {
+			key ^= random64[en_passant_key_offset + index(col(state.en_passant_target))];
+		}
+	}
+	if(state.active_color == ChessPieceColor::White) {
+		key ^= random64[turn_key_offset];
+	}
+	return key;
+}
+
+std::uint64_t PolyglotBook::Entry::key() const {
+	return read_big_endian<8u>(bytes.data());
+}
+
+std::uint16_t PolyglotBook::Entry::move() const {
+	return static_cast<std::uint16_t>(read_big_endian<2u>(bytes.data() + 8u));
+}
+
+std::uint16_t PolyglotBook::Entry::weight() const {
+	return static_cast<std::uint16_t>(read_big_endian<2u>(bytes.data() + 10u));
+}
+
+static_assert(sizeof(PolyglotBook::Entry) == 16u);
+
+PolyglotBook::PolyglotBook(const bfs::path& path):
+	file_(path.string().c_str(), bip::read_only),
+	region_(file_, bip::read_only)
+{
+	if(region_.get_size() % sizeof(Entry) != 0u) {
+		throw std::runtime_error(fmt::format("Polyglot book '{}' is truncated.", path.string()));
+	}
+}
+
+std::size_t PolyglotBook::size() const {
+	return region_.get_size() / sizeof(Entry);
+}
+
+const PolyglotBook::Entry* PolyglotBook::begin() const {
+	return static_cast<const Entry*>(region_.get_address());
+}
+
+const PolyglotBook::Entry* PolyglotBook::end() const {
+	return begin() + size();
+}
+
+std::pair<const PolyglotBook::Entry*, const PolyglotBook::Entry*> PolyglotBook::equal_range(std::uint64_t key) const {
+	auto first = std::partition_point(begin(), end(), [key](const Entry& e) { return e.key() < key; });
+	auto last = std::partition_point(first, end(), [key](const Entry& e) { return e.key() == key; });
+	return {first, last};
+}
+
+std::optional<PackedMove> PolyglotBook::decode_move(const Board& board, const TemporalGameState& state, std::uint16_t move) {
+	auto to = make_board_pos(col_from_index(move & 7u), row_from_index((move >> 3u) & 7u));
+	auto from = make_board_pos(col_from_index((move >> 6u) & 7u), row_from_index((move >> 9u) & 7u));
+	auto promotion_bits = (move >> 12u) & 7u;
+	if(promotion_bits > 4u) {
+		return std::nullopt;
+	}
+	std::optional<ChessPieceKind> promotion;
+	if(promotion_bits != 0u) {
+		// 1 through 4 are knight through queen, as in ChessPieceKind.
+		promotion = static_cast<ChessPieceKind>(promotion_bits);
+	}
+	auto piece = board[from];
+	if(piece and kind(*piece) == ChessPieceKind::King and col(from) == 'E'_col and row(from) == row(to)) {
+		if(col(to) == 'H'_col) {
+			to = make_board_pos('G'_col, row(to));
+		} else if(col(to) == 'A'_col) {
+			to = make_board_pos('C'_col, row(to));
+		}
+	}
+	PackedMove mv(from, to, promotion);
+	if(not is_legal(board, state, mv)) {
+		return std::nullopt;
+	}
+	return mv;
+}
+
+std::vector<BookMove> PolyglotBook::moves(const GameSnapshot& snapshot) const {
+	std::vector<BookMove> result;
+	auto [first, last] = equal_range(polyglot_hash(snapshot));
+	if(first == last) {
+		return result;
+	}
+	auto board = snapshot.board.decompressed();
+	for(; first != last; ++first) {
+		if(auto mv = decode_move(board, snapshot.temporal_state, first->move())) {
+			result.push_back(BookMove{*mv, first->weight()});
+		}
+	}
+	return result;
+}
+
+std::optional<PackedMove> PolyglotBook::choose(const GameSnapshot& snapshot, std::uint64_t random) const {
+	auto [first, last] = equal_range(polyglot_hash(snapshot));
+	if(first == last) {
+		return std::nullopt;
+	}
+	auto board = snapshot.board.decompressed();
+	const auto& state = snapshot.temporal_state;
+	// Two passes over the (few) entries instead of collecting them: one for the total weight
+	// of the legal moves and one to find where 'random' lands.
+	std::uint64_t total = 0u;
+	for(auto e = first; e != last; ++e) {
+		if(e->weight() != 0u and decode_move(board, state, e->move())) {
+			total += e->weight();
+		}
+	}
+	if(total == 0u) {
+		return std::nullopt;
+	}
+	auto pick = random % total;
+	for(auto e = first; e != last; ++e) {
+		if(e->weight() == 0u) {
+			continue;
+		}
+		auto mv = decode_move(board, state, e->move());
+		if(not mv) {
+			continue;
+		}
+		if(pick < e->weight()) {
+			return mv;
+		}
+		pick -= e->weight();
+	}
+	return std::nullopt;
+}
+
+} /* namespace ac */
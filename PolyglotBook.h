@@ -0,0 +1,77 @@
+#ifndef AC_POLYGLOT_BOOK_H
+#define AC_POLYGLOT_BOOK_H
+
+#include "attack_sets.h"
+#include "Board.h"
+#include "ChessPiece.h"
+#include "GameSnapshot.h"
+#include "Move.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem/path.hpp>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace ac {
+
+namespace bip = boost::interprocess;
+namespace bfs = boost::filesystem;
+
+// Polyglot hash of 'snapshot'.  Following Polyglot, the en passant file only counts when a
+// pawn of the side to move stands ready to make the capture.
+std::uint64_t polyglot_hash(const GameSnapshot& snapshot);
+
+struct BookMove {
+	PackedMove move;
+	std::uint16_t weight;
+};
+
+// A Polyglot '.bin' opening book.  The file is memory-mapped and never copied; it is an
+// array of 16-byte big-endian entries (key, move, weight, learn) sorted by key, so a
+// position's moves are found with a binary search.
+struct PolyglotBook {
+	// Raw on-disk entry.
+	struct Entry {
+		std::array<unsigned char, 16u> bytes;
+
+		std::uint64_t key() const;
+		std::uint16_t move() const;
+		std::uint16_t weight() const;
+	};
+
+	explicit PolyglotBook(const bfs::path& path);
+
+	PolyglotBook(const PolyglotBook&) = delete;
+	PolyglotBook& operator=(const PolyglotBook&) = delete;
+
+	// Number of entries in the book.
+	std::size_t size() const;
+
+	// The book's moves for 'snapshot', in book order.  Entries that aren't legal in the
+	// position (hash collisions, corrupt books) are dropped.
+	std::vector<BookMove> moves(const GameSnapshot& snapshot) const;
+
+	// Pick one of the book's moves for 'snapshot' with probability proportional to its
+	// weight, using 'random' as a uniformly distributed number.  Returns std::nullopt if the
+	// position isn't in the book or all of its moves have zero weight.
+	std::optional<PackedMove> choose(const GameSnapshot& snapshot, std::uint64_t random) const;
+
+private:
+	const Entry* begin() const;
+	const Entry* end() const;
+	std::pair<const Entry*, const Entry*> equal_range(std::uint64_t key) const;
+
+	// Translate a Polyglot move into ours, or std::nullopt if it isn't legal in the position.
+	// Polyglot encodes castling as the king capturing its own rook.
+	static std::optional<PackedMove> decode_move(const Board& board, const TemporalGameState& state, std::uint16_t move);
+
+	bip::file_mapping file_;
+	bip::mapped_region region_;
+};
+
+} /* namespace ac */
+
+#endif /* AC_POLYGLOT_BOOK_H */
@@ -0,0 +1,185 @@
+#ifndef AC_POSITION_H
+#define AC_POSITION_H
+
+#include "Board.h"
+#include "ChessPiece.h"
+#include "Evaluation.h"
+#include "GameSnapshot.h"
+#include "MaterialSignature.h"
+#include "Move.h"
+#include "Zobrist.h"
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace ac {
+
+// A position for walking move trees in place: the board, the temporal state, and the
+// Zobrist hash, evaluation and material kept up to date by make_move()/unmake_move().
+struct Position {
+	Board board;
+	TemporalGameState state;
+	std::uint64_t hash;
+	Evaluation eval;
+	MaterialSignature material;
+
+	Position() = default;
+
+	explicit Position(const GameSnapshot& snapshot):
+		board(snapshot.board.decompressed()),
+		state(snapshot.temporal_state),
+		hash(zobrist_hash(snapshot)),
+		eval(evaluate(board)),
+		material(material_signature(board))
+	{
+
+	}
+
+	GameSnapshot snapshot() const {
+		return GameSnapshot{board.compressed(), state};
+	}
+};
+
+// What unmake_move() needs to take a move back: everything make_move() can't recompute
+// from the move alone.
+struct UndoRecord {
+	PackedMove move;
+	std::optional<ChessPiece> captured;
+	TemporalGameState state;
+	std::uint64_t hash;
+	Evaluation eval;
+};
+
+// Fixed-capacity stack of undo records; deep enough for any search or perft run.
+struct UndoStack {
+	static constexpr std::size_t capacity = 256u;
+
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr bool empty() const {
+		return size_ == 0u;
+	}
+
+	constexpr void push(const UndoRecord& record) {
+		assert(size_ < capacity);
+		records_[size_++] = record;
+	}
+
+	constexpr UndoRecord pop() {
+		assert(size_ > 0u);
+		return records_[--size_];
+	}
+
+	constexpr const UndoRecord& top() const {
+		assert(size_ > 0u);
+		return records_[size_ - 1u];
+	}
+
+	constexpr void clear() {
+		size_ = 0u;
+	}
+
+private:
+	std::array<UndoRecord, capacity> records_ = {};
+	std::size_t size_ = 0u;
+};
+
+namespace detail {
+
+constexpr bool is_castle_move(ChessPiece piece, BoardPos from, BoardPos to) {
+	return kind(piece) == ChessPieceKind::King
+		and (index(col(from)) == index(col(to)) + 2u or index(col(to)) == index(col(from)) + 2u);
+}
+
+constexpr std::pair<BoardPos, BoardPos> castle_rook_move(BoardPos king_to) {
+	auto kingside = col(king_to) == 'G'_col;
+	return {
+		make_board_pos(kingside ? 'H'_col : 'A'_col, row(king_to)),
+		make_board_pos(kingside ? 'F'_col : 'D'_col, row(king_to))
+	};
+}
+
+} /* namespace detail */
+
+// Play the legal move 'mv' on 'position' in place, pushing what it takes to undo it onto
+// 'undo'.
+constexpr void make_move(Position& position, PackedMove mv, UndoStack& undo) {
+	auto& board = position.board;
+	auto& hash = position.hash;
+	auto from = mv.start_position();
+	auto to = mv.end_position();
+	auto piece = std::as_const(board)[from];
+	assert(piece);
+	auto c = color(*piece);
+	auto captured = std::as_const(board)[to];
+	auto captured_at = to;
+	if(not captured and kind(*piece) == ChessPieceKind::Pawn and col(from) != col(to)) {
+		captured_at = make_board_pos(col(to), row(from));
+		captured = opposite_color(c) + ChessPieceKind::Pawn;
+	}
+	undo.push(UndoRecord{mv, captured, position.state, hash, position.eval});
+	apply_move(position.eval, board, mv);
+	apply_move(position.material, board, mv);
+	if(captured) {
+		board.remove_piece(*captured, captured_at);
+		hash ^= zobrist_key(*captured, captured_at);
+	} else if(detail::is_castle_move(*piece, from, to)) {
+		auto [rook_from, rook_to] = detail::castle_rook_move(to);
+		auto rook = c + ChessPieceKind::Rook;
+		board.remove_piece(rook, rook_from);
+		board.put_piece(rook, rook_to);
+		hash ^= zobrist_key(rook, rook_from) ^ zobrist_key(rook, rook_to);
+	}
+	auto placed = mv.promotion() ? c + *mv.promotion() : *piece;
+	board.remove_piece(*piece, from);
+	board.put_piece(placed, to);
+	hash ^= zobrist_key(*piece, from) ^ zobrist_key(placed, to);
+	auto& state = position.state;
+	hash ^= zobrist_key(state.castle_status);
+	if(state.en_passant_possible) {
+		hash ^= zobrist_en_passant_key(state.en_passant_target);
+	}
+	advance_temporal_state(state, *piece, mv, captured.has_value());
+	hash ^= zobrist_key(state.castle_status);
+	if(state.en_passant_possible) {
+		hash ^= zobrist_en_passant_key(state.en_passant_target);
+	}
+	hash ^= zobrist_black_to_move_key();
+}
+
+// Take back the move on top of 'undo', which must be the last move made on 'position'.
+constexpr void unmake_move(Position& position, UndoStack& undo) {
+	auto record = undo.pop();
+	auto& board = position.board;
+	auto mv = record.move;
+	auto from = mv.start_position();
+	auto to = mv.end_position();
+	auto placed = std::as_const(board)[to];
+	assert(placed);
+	auto c = color(*placed);
+	auto piece = mv.promotion() ? c + ChessPieceKind::Pawn : *placed;
+	board.remove_piece(*placed, to);
+	board.put_piece(piece, from);
+	if(record.captured) {
+		const auto& before = record.state;
+		auto en_passant = kind(piece) == ChessPieceKind::Pawn and before.en_passant_possible and before.en_passant_target == to;
+		board.put_piece(*record.captured, en_passant ? make_board_pos(col(to), row(from)) : to);
+	} else if(detail::is_castle_move(piece, from, to)) {
+		auto [rook_from, rook_to] = detail::castle_rook_move(to);
+		auto rook = c + ChessPieceKind::Rook;
+		board.remove_piece(rook, rook_to);
+		board.put_piece(rook, rook_from);
+	}
+	undo_move(position.material, board, mv);
+	position.state = record.state;
+	position.hash = record.hash;
+	position.eval = record.eval;
+}
+
+} /* namespace ac */
+
+#endif /* AC_POSITION_H */
@@ -0,0 +1,308 @@
+#include "PositionTable.h"
+#include "batch_move_counts.h"
+#include "Board.h"
+#include <fmt/format.h>
+#include <cassert>
+#include <stdexcept>
+
+namespace ac {
+
+namespace {
+
+// Bits of the dark squares (a1, c1, ..., b2, ...); squares are indexed column by column.
+constexpr std::uint64_t dark_squares = 0xaa55aa55aa55aa55u;
+
+// Whether the king among 'pieces' (indexed by ChessPieceKind) is attacked by 'enemy', for
+// the lanes' worth of positions starting at 'i'.  'white' is all ones if the king is white.
+template <typename V>
+V king_attacked(
+	const std::array<const std::uint64_t*, 6u>& pieces,
+	const std::array<const std::uint64_t*, 6u>& enemy,
+	std::size_t i,
+	V white
+) {
+	using traits = detail::LaneTraits<V>;
+	auto load = [&](const std::array<const std::uint64_t*, 6u>& columns, ChessPieceKind k) {
+		return traits::load(columns[static_cast<std::size_t>(k)] + i);
+	};
+	auto occupied = traits::splat(0u);
+	for(std::size_t k = 0u; k < 6u; ++k) {
+		occupied = occupied | traits::load(pieces[k] + i) | traits::load(enemy[k] + i);
+	}
+	auto empty = ~occupied;
+	auto king = load(pieces, ChessPieceKind::King);
+	auto queens = load(enemy, ChessPieceKind::Queen);
+	auto orthogonal = load(enemy, ChessPieceKind::Rook) | queens;
+	auto diagonal = load(enemy, ChessPieceKind::Bishop) | queens;
+	auto knights = load(enemy, ChessPieceKind::Knight);
+	auto kings = load(enemy, ChessPieceKind::King);
+	// Look outwards from the king: it's attacked by whatever it would attack as each kind of
+	// piece.
+	auto attackers = (detail::pawn_captures_west(king, white) | detail::pawn_captures_east(king, white))
+		& load(enemy, ChessPieceKind::Pawn);
+	detail::for_each_step<detail::KnightSteps>([&](auto step) {
+		attackers = attackers | (step.from(king) & knights);
+	});
+	detail::for_each_step<detail::RookSteps>([&](auto step) {
+		attackers = attackers | (step.slide(king, empty) & orthogonal) | (step.from(king) & kings);
+	});
+	detail::for_each_step<detail::BishopSteps>([&](auto step) {
+		attackers = attackers | (step.slide(king, empty) & diagonal) | (step.from(king) & kings);
+	});
+	return detail::nonzero(attackers);
+}
+
+} /* namespace */
+
+PositionSelection& PositionSelection::operator&=(const PositionSelection& other) {
+	assert(flags.size() == other.flags.size());
+	for(std::size_t i = 0u; i < flags.size(); ++i) {
+		flags[i] &= other.flags[i];
+	}
+	return *this;
+}
+
+PositionSelection& PositionSelection::operator|=(const PositionSelection& other) {
+	assert(flags.size() == other.flags.size());
+	for(std::size_t i = 0u; i < flags.size(); ++i) {
+		flags[i] |= other.flags[i];
+	}
+	return *this;
+}
+
+std::size_t PositionSelection::count() const {
+	std::size_t n = 0u;
+	for(auto flag: flags) {
+		n += flag;
+	}
+	return n;
+}
+
+std::vector<std::size_t> PositionSelection::indices() const {
+	std::vector<std::size_t> result;
+	for(std::size_t i = 0u; i < flags.size(); ++i) {
+		if(flags[i]) {
+			result.push_back(i);
+		}
+	}
+	return result;
+}
+
+std::size_t PositionTable::size() const {
+	return active_colors_.size();
+}
+
+bool PositionTable::empty() const {
+	return active_colors_.empty();
+}
+
+void PositionTable::reserve(std::size_t count) {
+	for(auto& column: pieces_) {
+		column.reserve(count);
+	}
+	active_colors_.reserve(count);
+	castle_statuses_.reserve(count);
+	en_passant_targets_.reserve(count);
+	halfmove_clocks_.reserve(count);
+	fullmove_numbers_.reserve(count);
+	materials_.reserve(count);
+}
+
+void PositionTable::clear() {
+	for(auto& column: pieces_) {
+		column.clear();
+	}
+	active_colors_.clear();
+	castle_statuses_.clear();
+	en_passant_targets_.clear();
+	halfmove_clocks_.clear();
+	fullmove_numbers_.clear();
+	materials_.clear();
+}
+
+void PositionTable::append(const GameSnapshot& snapshot) {
+	auto board = snapshot.board.decompressed();
+	for(std::size_t i = 0u; i < 12u; ++i) {
+		pieces_[i].push_back(board.positions(chess_piece_from_index(i)).bits());
+	}
+	const auto& state = snapshot.temporal_state;
+	active_colors_.push_back(state.active_color);
+	castle_statuses_.push_back(state.castle_status);
+	en_passant_targets_.push_back(state.en_passant_possible ? static_cast<std::uint8_t>(index(state.en_passant_target)) : no_en_passant);
+	halfmove_clocks_.push_back(static_cast<std::uint8_t>(state.halfmove_clock));
+	fullmove_numbers_.push_back(static_cast<std::uint16_t>(state.fullmove_number));
+	materials_.push_back(material_signature(board).key());
+}
+
+void PositionTable::append(const GameSnapshot* snapshots, std::size_t count) {
+	reserve(size() + count);
+	for(std::size_t i = 0u; i < count; ++i) {
+		append(snapshots[i]);
+	}
+}
+
+void PositionTable::append(const std::vector<GameSnapshot>& snapshots) {
+	append(snapshots.data(), snapshots.size());
+}
+
+GameSnapshot PositionTable::snapshot(std::size_t i) const {
+	GameSnapshot result;
+	export_snapshots(i, 1u, &result);
+	return result;
+}
+
+void PositionTable::export_snapshots(std::size_t first, std::size_t count, GameSnapshot* out) const {
+	if(first > size() or count > size() - first) {
+		throw std::out_of_range(fmt::format(
+			"Positions [{}, {}) are out of range for a position table of size {}.", first, first + count, size()
+		));
+	}
+	for(std::size_t n = 0u; n < count; ++n) {
+		auto i = first + n;
+		Board board;
+		for(std::size_t p = 0u; p < 12u; ++p) {
+			auto piece = chess_piece_from_index(p);
+			for(auto pos: BitBoard::from_bits(pieces_[p][i]).positions()) {
+				board.put_piece(piece, pos);
+			}
+		}
+		auto& state = out[n].temporal_state;
+		state.active_color = active_colors_[i];
+		state.castle_status = castle_statuses_[i];
+		state.en_passant_possible = en_passant_targets_[i] != no_en_passant;
+		state.en_passant_target = state.en_passant_possible ? board_pos_from_index(en_passant_targets_[i]) : board_pos_from_index(0u);
+		state.halfmove_clock = halfmove_clocks_[i];
+		state.fullmove_number = fullmove_numbers_[i];
+		out[n].board = board.compressed();
+	}
+}
+
+std::vector<GameSnapshot> PositionTable::export_snapshots(const PositionSelection& selection) const {
+	assert(selection.flags.size() == size());
+	std::vector<GameSnapshot> result;
+	result.reserve(selection.count());
+	for(auto i: selection.indices()) {
+		result.push_back(snapshot(i));
+	}
+	return result;
+}
+
+const std::vector<std::uint64_t>& PositionTable::pieces(ChessPiece piece) const {
+	return pieces_[index(piece)];
+}
+
+const std::vector<ChessPieceColor>& PositionTable::active_colors() const {
+	return active_colors_;
+}
+
+const std::vector<CastleStatus>& PositionTable::castle_statuses() const {
+	return castle_statuses_;
+}
+
+const std::vector<std::uint8_t>& PositionTable::en_passant_targets() const {
+	return en_passant_targets_;
+}
+
+const std::vector<std::uint8_t>& PositionTable::halfmove_clocks() const {
+	return halfmove_clocks_;
+}
+
+const std::vector<std::uint16_t>& PositionTable::fullmove_numbers() const {
+	return fullmove_numbers_;
+}
+
+const std::vector<std::uint64_t>& PositionTable::materials() const {
+	return materials_;
+}
+
+// The scans below are plain loops over one or two columns with no branches, which the
+// compiler vectorizes; select_in_check() does so explicitly.
+
+PositionSelection PositionTable::select_side_to_move(ChessPieceColor c) const {
+	PositionSelection result{std::vector<std::uint8_t>(size())};
+	for(std::size_t i = 0u; i < size(); ++i) {
+		result.flags[i] = active_colors_[i] == c;
+	}
+	return result;
+}
+
+PositionSelection PositionTable::select_castle_rights(CastleStatus rights) const {
+	PositionSelection result{std::vector<std::uint8_t>(size())};
+	for(std::size_t i = 0u; i < size(); ++i) {
+		result.flags[i] = (castle_statuses_[i] & rights) == rights;
+	}
+	return result;
+}
+
+PositionSelection PositionTable::select_piece_count(ChessPiece piece, std::size_t min, std::size_t max) const {
+	PositionSelection result{std::vector<std::uint8_t>(size())};
+	const auto& column = pieces_[index(piece)];
+	for(std::size_t i = 0u; i < size(); ++i) {
+		auto n = static_cast<std::size_t>(psnip_builtin_popcount64(column[i]));
+		result.flags[i] = n >= min and n <= max;
+	}
+	return result;
+}
+
+PositionSelection PositionTable::select_pieces_on(ChessPiece piece, BitBoard squares) const {
+	PositionSelection result{std::vector<std::uint8_t>(size())};
+	const auto& column = pieces_[index(piece)];
+	auto bits = squares.bits();
+	for(std::size_t i = 0u; i < size(); ++i) {
+		result.flags[i] = (column[i] & bits) == bits;
+	}
+	return result;
+}
+
+PositionSelection PositionTable::select_bishop_pair(ChessPieceColor c) const {
+	PositionSelection result{std::vector<std::uint8_t>(size())};
+	const auto& column = pieces_[index(c + ChessPieceKind::Bishop)];
+	for(std::size_t i = 0u; i < size(); ++i) {
+		result.flags[i] = (column[i] & dark_squares) != 0u and (column[i] & ~dark_squares) != 0u;
+	}
+	return result;
+}
+
+PositionSelection PositionTable::select_in_check(ChessPieceColor c) const {
+	using lane_type = detail::BatchLanes;
+	using traits = detail::LaneTraits<lane_type>;
+	PositionSelection result{std::vector<std::uint8_t>(size())};
+	std::array<const std::uint64_t*, 6u> own;
+	std::array<const std::uint64_t*, 6u> enemy;
+	for(std::size_t k = 0u; k < 6u; ++k) {
+		own[k] = pieces_[index(c + static_cast<ChessPieceKind>(k))].data();
+		enemy[k] = pieces_[index(opposite_color(c) + static_cast<ChessPieceKind>(k))].data();
+	}
+	auto white = c == ChessPieceColor::White ? ~std::uint64_t(0u) : std::uint64_t(0u);
+	std::size_t i = 0u;
+	for(; i + traits::lanes <= size(); i += traits::lanes) {
+		std::array<std::uint64_t, traits::lanes> attacked;
+		traits::store(king_attacked(own, enemy, i, traits::splat(white)), attacked.data());
+		for(std::size_t lane = 0u; lane < traits::lanes; ++lane) {
+			result.flags[i + lane] = attacked[lane] != 0u;
+		}
+	}
+	for(; i < size(); ++i) {
+		result.flags[i] = king_attacked<std::uint64_t>(own, enemy, i, white) != 0u;
+	}
+	return result;
+}
+
+PositionSelection PositionTable::select_material(MaterialSignature material) const {
+	PositionSelection result{std::vector<std::uint8_t>(size())};
+	auto key = material.key();
+	for(std::size_t i = 0u; i < size(); ++i) {
+		result.flags[i] = materials_[i] == key;
+	}
+	return result;
+}
+
+PositionSelection PositionTable::select_insufficient_material() const {
+	PositionSelection result{std::vector<std::uint8_t>(size())};
+	for(std::size_t i = 0u; i < size(); ++i) {
+		result.flags[i] = insufficient_material(MaterialSignature::from_key(materials_[i]));
+	}
+	return result;
+}
+
+} /* namespace ac */
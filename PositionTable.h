@@ -0,0 +1,94 @@
+#ifndef AC_POSITION_TABLE_H
+#define AC_POSITION_TABLE_H
+
+#include "BitBoard.h"
+#include "ChessPiece.h"
+#include "GameSnapshot.h"
+#include "MaterialSignature.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace ac {
+
+// One flag per position of a PositionTable, as produced by its scans.  Selections of the same
+// table combine with '&=' and '|='.
+struct PositionSelection {
+	std::vector<std::uint8_t> flags;
+
+	PositionSelection& operator&=(const PositionSelection& other);
+	PositionSelection& operator|=(const PositionSelection& other);
+
+	// Number of positions selected.
+	std::size_t count() const;
+
+	// Indices of the positions selected, in increasing order.
+	std::vector<std::size_t> indices() const;
+};
+
+// Large sets of positions stored column-wise: each of the twelve piece bitboards, the side to
+// move, castling rights, en passant target, both clocks and the material signature live in
+// their own contiguous array.  Scans read only the columns they need and sweep them in
+// order, e.g. for white having the bishop pair and being in check:
+//
+//	auto selection = table.select_bishop_pair(ChessPieceColor::White);
+//	selection &= table.select_in_check(ChessPieceColor::White);
+struct PositionTable {
+	// Value of the en passant column when there is no en passant target.
+	static constexpr std::uint8_t no_en_passant = 0xffu;
+
+	std::size_t size() const;
+	bool empty() const;
+	void reserve(std::size_t count);
+	void clear();
+
+	void append(const GameSnapshot& snapshot);
+	void append(const GameSnapshot* snapshots, std::size_t count);
+	void append(const std::vector<GameSnapshot>& snapshots);
+
+	GameSnapshot snapshot(std::size_t i) const;
+	// Write positions [first, first + count) to 'out'.
+	void export_snapshots(std::size_t first, std::size_t count, GameSnapshot* out) const;
+	std::vector<GameSnapshot> export_snapshots(const PositionSelection& selection) const;
+
+	// The columns, one element per position.
+	const std::vector<std::uint64_t>& pieces(ChessPiece piece) const;
+	const std::vector<ChessPieceColor>& active_colors() const;
+	const std::vector<CastleStatus>& castle_statuses() const;
+	// Square index of the en passant target, or 'no_en_passant'.
+	const std::vector<std::uint8_t>& en_passant_targets() const;
+	const std::vector<std::uint8_t>& halfmove_clocks() const;
+	const std::vector<std::uint16_t>& fullmove_numbers() const;
+	// Keys of the positions' material signatures.
+	const std::vector<std::uint64_t>& materials() const;
+
+	// Positions where 'c' is to move.
+	PositionSelection select_side_to_move(ChessPieceColor c) const;
+	// Positions where all of 'rights' are still held.
+	PositionSelection select_castle_rights(CastleStatus rights) const;
+	// Positions with between 'min' and 'max' (inclusive) of 'piece'.
+	PositionSelection select_piece_count(ChessPiece piece, std::size_t min, std::size_t max = 64u) const;
+	// Positions where 'piece' stands on every one of 'squares'.
+	PositionSelection select_pieces_on(ChessPiece piece, BitBoard squares) const;
+	// Positions where 'c' has bishops on both light and dark squares.
+	PositionSelection select_bishop_pair(ChessPieceColor c) const;
+	// Positions where 'c''s king is attacked.
+	PositionSelection select_in_check(ChessPieceColor c) const;
+	// Positions with exactly 'material' on the board.
+	PositionSelection select_material(MaterialSignature material) const;
+	// Positions whose material alone rules out checkmate (see insufficient_material()).
+	PositionSelection select_insufficient_material() const;
+
+private:
+	std::array<std::vector<std::uint64_t>, 12u> pieces_;
+	std::vector<ChessPieceColor> active_colors_;
+	std::vector<CastleStatus> castle_statuses_;
+	std::vector<std::uint8_t> en_passant_targets_;
+	std::vector<std::uint8_t> halfmove_clocks_;
+	std::vector<std::uint16_t> fullmove_numbers_;
+	std::vector<std::uint64_t> materials_;
+};
+
+} /* namespace ac */
+
+#endif /* AC_POSITION_TABLE_H */
@@ -0,0 +1,253 @@
+#include "QuickSearch.h"
+#include "attack_sets.h"
+#include "move_generation.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace ac {
+
+namespace {
+
+constexpr int infinity        = 32000;
+constexpr int mate_value      = 31000;
+// Scores beyond this are mates, with the distance to mate folded in.
+constexpr int mate_threshold  = mate_value - static_cast<int>(QuickSearch::max_ply);
+// How often (in nodes) the clock is read.
+constexpr std::size_t clock_check_interval = 256u;
+
+constexpr int centipawns(ChessPieceKind k) {
+	return k == ChessPieceKind::King ? 0 : 100 * static_cast<int>(material_value(k));
+}
+
+// Mate scores are stored relative to the node rather than the root, so they stay correct
+// when the entry is found at another ply.
+constexpr int score_to_table(int score, std::size_t ply) {
+	auto p = static_cast<int>(ply);
+	return score >= mate_threshold ? score + p : score <= -mate_threshold ? score - p : score;
+}
+
+constexpr int score_from_table(int score, std::size_t ply) {
+	auto p = static_cast<int>(ply);
+	return score >= mate_threshold ? score - p : score <= -mate_threshold ? score + p : score;
+}
+
+uci::Score uci_score(int score) {
+	if(score >= mate_threshold) {
+		return uci::Score{uci::ScoreKind::Mate, (mate_value - score + 1) / 2};
+	} else if(score <= -mate_threshold) {
+		return uci::Score{uci::ScoreKind::Mate, -((mate_value + score + 1) / 2)};
+	}
+	return uci::Score{uci::ScoreKind::Centipawns, score};
+}
+
+// Hash move first, then captures by most valuable victim / least valuable attacker, then
+// promotions, then the rest in generation order.
+void order_moves(const Board& board, MoveList& moves, PackedMove hash_move) {
+	std::array<int, MoveList::capacity> keys = {};
+	for(std::size_t i = 0u; i < moves.size(); ++i) {
+		auto mv = moves[i];
+		int key = 0;
+		if(mv == hash_move) {
+			key = infinity;
+		} else {
+			if(auto victim = board[mv.end_position()]) {
+				key += 10 * centipawns(kind(*victim)) + 1000 - centipawns(kind(*board[mv.start_position()])) / 10;
+			}
+			if(auto promotion = mv.promotion()) {
+				key += centipawns(*promotion);
+			}
+		}
+		keys[i] = key;
+	}
+	// Insertion sort; move lists are short and mostly need little reordering.
+	for(std::size_t i = 1u; i < moves.size(); ++i) {
+		auto mv = moves[i];
+		auto key = keys[i];
+		auto j = i;
+		for(; j > 0u and keys[j - 1u] < key; --j) {
+			moves[j] = moves[j - 1u];
+			keys[j] = keys[j - 1u];
+		}
+		moves[j] = mv;
+		keys[j] = key;
+	}
+}
+
+} /* namespace */
+
+QuickSearch::QuickSearch(std::size_t table_size):
+	table_()
+{
+	std::size_t size = 1u;
+	while(size < table_size) {
+		size <<= 1u;
+	}
+	table_.resize(size);
+}
+
+std::size_t QuickSearch::nodes() const {
+	return nodes_;
+}
+
+void QuickSearch::clear() {
+	std::fill(table_.begin(), table_.end(), TableEntry());
+}
+
+SearchResult QuickSearch::search(const GameSnapshot& snapshot, const QuickSearchLimits& limits) {
+	if(not limits.nodes and not limits.time) {
+		throw std::invalid_argument("QuickSearch::search() needs a node or time limit.");
+	}
+	nodes_ = 0u;
+	stopped_ = false;
+	node_limit_ = limits.nodes.value_or(std::numeric_limits<std::size_t>::max());
+	deadline_ = std::nullopt;
+	if(limits.time) {
+		deadline_ = clock_type::now() + *limits.time;
+	}
+	position_ = Position(snapshot);
+	undo_.clear();
+	SearchResult result;
+	MoveList root_moves;
+	generate_legal_moves(position_.board, position_.state, root_moves);
+	if(root_moves.empty()) {
+		return result;
+	}
+	result.best_move = root_moves[0];
+	auto max_depth = std::min(limits.depth, max_ply - 1u);
+	for(std::size_t depth = 1u; depth <= max_depth; ++depth) {
+		auto score = alpha_beta(static_cast<int>(depth), 0u, -infinity, infinity);
+		if(stopped_) {
+			break;
+		}
+		result.depth = depth;
+		result.score = uci_score(score);
+		result.pv.assign(pv_[0].begin(), pv_[0].begin() + pv_length_[0]);
+		if(not result.pv.empty()) {
+			result.best_move = result.pv[0];
+			result.ponder_move = result.pv.size() > 1u ? std::optional<PackedMove>(result.pv[1]) : std::nullopt;
+		}
+		if(score >= mate_threshold or score <= -mate_threshold) {
+			// Deeper iterations won't find a shorter mate.
+			break;
+		}
+	}
+	return result;
+}
+
+bool QuickSearch::should_stop() {
+	if(not stopped_) {
+		stopped_ = nodes_ >= node_limit_
+			or (deadline_ and nodes_ % clock_check_interval == 0u and clock_type::now() >= *deadline_);
+	}
+	return stopped_;
+}
+
+bool QuickSearch::repeated(std::size_t ply) const {
+	// Only positions since the last capture or pawn move can repeat, and only every other ply.
+	auto reversible = std::min<std::size_t>(position_.state.halfmove_clock, ply);
+	for(std::size_t back = 4u; back <= reversible; back += 2u) {
+		if(path_[ply - back] == position_.hash) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int QuickSearch::alpha_beta(int depth, std::size_t ply, int alpha, int beta) {
+	pv_length_[ply] = 0u;
+	path_[ply] = position_.hash;
+	if(ply > 0u and (position_.state.halfmove_clock >= 100u or repeated(ply))) {
+		return 0;
+	}
+	if(depth <= 0 or ply + 1u >= max_ply) {
+		return quiescence(ply, alpha, beta);
+	}
+	if(should_stop()) {
+		return 0;
+	}
+	++nodes_;
+	auto& entry = table_[position_.hash & (table_.size() - 1u)];
+	auto hash_move = PackedMove();
+	if(entry.key == position_.hash) {
+		hash_move = entry.move;
+		if(ply > 0u and entry.depth >= depth) {
+			auto score = score_from_table(entry.score, ply);
+			if(entry.bound == Bound::Exact
+				or (entry.bound == Bound::Lower and score >= beta)
+				or (entry.bound == Bound::Upper and score <= alpha))
+			{
+				return score;
+			}
+		}
+	}
+	MoveList moves;
+	generate_legal_moves(position_.board, position_.state, moves);
+	if(moves.empty()) {
+		return in_check(position_.board, position_.state.active_color) ? -(mate_value - static_cast<int>(ply)) : 0;
+	}
+	order_moves(position_.board, moves, hash_move);
+	auto original_alpha = alpha;
+	auto best_score = -infinity;
+	auto best_move = moves[0];
+	for(auto mv: moves) {
+		make_move(position_, mv, undo_);
+		auto score = -alpha_beta(depth - 1, ply + 1u, -beta, -alpha);
+		unmake_move(position_, undo_);
+		if(stopped_) {
+			return 0;
+		}
+		if(score > best_score) {
+			best_score = score;
+			best_move = mv;
+			if(score > alpha) {
+				alpha = score;
+				pv_[ply][0] = mv;
+				std::copy_n(pv_[ply + 1u].begin(), pv_length_[ply + 1u], pv_[ply].begin() + 1);
+				pv_length_[ply] = pv_length_[ply + 1u] + 1u;
+			}
+		}
+		if(alpha >= beta) {
+			break;
+		}
+	}
+	entry.key = position_.hash;
+	entry.move = best_move;
+	entry.score = static_cast<std::int16_t>(score_to_table(best_score, ply));
+	entry.depth = static_cast<std::uint8_t>(depth);
+	entry.bound = best_score <= original_alpha ? Bound::Upper : best_score >= beta ? Bound::Lower : Bound::Exact;
+	return best_score;
+}
+
+int QuickSearch::quiescence(std::size_t ply, int alpha, int beta) {
+	pv_length_[ply] = 0u;
+	if(should_stop()) {
+		return 0;
+	}
+	++nodes_;
+	auto stand_pat = position_.eval.score(position_.state.active_color);
+	if(stand_pat >= beta or ply + 1u >= max_ply) {
+		return stand_pat;
+	}
+	alpha = std::max(alpha, stand_pat);
+	MoveList moves;
+	generate_legal_moves(position_.board, position_.state, moves, MoveSelection::Tactical);
+	order_moves(position_.board, moves, PackedMove());
+	for(auto mv: moves) {
+		make_move(position_, mv, undo_);
+		auto score = -quiescence(ply + 1u, -beta, -alpha);
+		unmake_move(position_, undo_);
+		if(stopped_) {
+			return 0;
+		}
+		if(score > alpha) {
+			alpha = score;
+			if(alpha >= beta) {
+				break;
+			}
+		}
+	}
+	return alpha;
+}
+
+} /* namespace ac */
@@ -0,0 +1,88 @@
+#ifndef AC_QUICK_SEARCH_H
+#define AC_QUICK_SEARCH_H
+
+#include "GameSnapshot.h"
+#include "Move.h"
+#include "Position.h"
+#include "SearchResult.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace ac {
+
+struct QuickSearchLimits {
+	// The search stops at whichever limit it reaches first.  The default node budget keeps a
+	// search well under a second; a depth of 32 alone would never finish.  Set 'nodes' to
+	// nullopt only together with a 'time' limit.
+	std::optional<std::size_t> nodes             = std::size_t(200000u);
+	std::optional<std::chrono::microseconds> time = std::nullopt;
+	std::size_t depth                            = 32u;
+};
+
+// Small in-process search for quick hints and blunder checks, where a round trip to the
+// external engine costs far more than the answer is worth: iterative deepening alpha-beta
+// with a quiescence search and a small transposition table.  Not thread-safe; use one per
+// thread.
+struct QuickSearch {
+	static constexpr std::size_t default_table_size = std::size_t(1u) << 16u;
+	static constexpr std::size_t max_ply            = 64u;
+
+	// 'table_size' is rounded up to a power of two.
+	explicit QuickSearch(std::size_t table_size = default_table_size);
+
+	// Search 'snapshot' within 'limits'.  The result is that of the deepest iteration that
+	// finished; if not even the first one did, 'best_move' is just some legal move.  It is
+	// only empty if the side to move has no legal move.  Throws std::invalid_argument if
+	// 'limits' has neither a node nor a time limit.
+	SearchResult search(const GameSnapshot& snapshot, const QuickSearchLimits& limits = QuickSearchLimits());
+
+	// Nodes visited by the last search.
+	std::size_t nodes() const;
+
+	// Forget everything in the transposition table.
+	void clear();
+
+private:
+	using clock_type = std::chrono::steady_clock;
+
+	enum class Bound: std::uint8_t {
+		Exact,
+		Lower,
+		Upper
+	};
+
+	struct TableEntry {
+		std::uint64_t key   = 0u;
+		PackedMove move     = PackedMove();
+		std::int16_t score  = 0;
+		std::uint8_t depth  = 0u;
+		Bound bound         = Bound::Exact;
+	};
+
+	int alpha_beta(int depth, std::size_t ply, int alpha, int beta);
+	int quiescence(std::size_t ply, int alpha, int beta);
+	bool repeated(std::size_t ply) const;
+	// Whether a limit has been hit; once it has, the search unwinds without further work.
+	bool should_stop();
+
+	std::vector<TableEntry> table_;
+	// The tree is walked with make/unmake on this one position.
+	Position position_;
+	UndoStack undo_;
+	std::size_t nodes_ = 0u;
+	std::size_t node_limit_ = 0u;
+	std::optional<clock_type::time_point> deadline_;
+	bool stopped_ = false;
+	// Principal variation found below each ply, triangular-array style.
+	std::array<std::array<PackedMove, max_ply>, max_ply> pv_ = {};
+	std::array<std::size_t, max_ply> pv_length_ = {};
+	// Hashes of the positions on the current path, for repetition detection.
+	std::array<std::uint64_t, max_ply> path_ = {};
+};
+
+} /* namespace ac */
+
+#endif /* AC_QUICK_SEARCH_H */
@@ -0,0 +1,63 @@
+#ifndef AC_SEARCH_RESULT_H
+#define AC_SEARCH_RESULT_H
+
+#include "Move.h"
+#include "UCI.h"
+#include <optional>
+#include <vector>
+#include <algorithm>
+
+namespace ac {
+
+// One of the lines of a MultiPV search.
+struct PVLine {
+	uci::Score score;
+	std::size_t depth = 0u;
+	std::vector<PackedMove> pv;
+};
+
+struct SearchResult {
+	std::optional<PackedMove> best_move   = std::nullopt;
+	std::optional<PackedMove> ponder_move = std::nullopt;
+	std::optional<uci::Score> score       = std::nullopt;
+	std::size_t depth                     = 0u;
+	std::vector<PackedMove> pv;
+	// The best lines found, best first, when the search was run with MultiPV > 1.
+	// 'lines[0]' mirrors 'score'/'depth'/'pv'.  Lines are overwritten in place as deeper
+	// iterations report them, so a line may briefly be one iteration behind its neighbours.
+	std::vector<PVLine> lines;
+
+	// Fold an 'info' line into the result.  Only complete, exact lines replace what we have;
+	// bound-only and per-move progress lines are ignored, as are lines for 'multipv 0'.
+	void update(const uci::InfoLine& info) {
+		auto idx = uci::pv_index(info);
+		if(not idx or not info.score or info.bound != uci::ScoreBound::Exact or info.pv.empty()) {
+			return;
+		}
+		auto line_depth = info.depth ? *info.depth : 0u;
+		if(info.multipv) {
+			if(lines.size() <= *idx) {
+				lines.resize(*idx + 1u);
+			}
+			auto& line = lines[*idx];
+			line.score = *info.score;
+			line.depth = line_depth;
+			line.pv = info.pv;
+			if(*idx != 0u) {
+				return;
+			}
+		}
+		score = info.score;
+		pv = info.pv;
+		depth = std::max(depth, line_depth);
+	}
+
+	void update(const uci::BestMove& bestmove) {
+		best_move = bestmove.move;
+		ponder_move = bestmove.ponder;
+	}
+};
+
+} /* namespace ac */
+
+#endif /* AC_SEARCH_RESULT_H */
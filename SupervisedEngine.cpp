@@ -0,0 +1,221 @@
+#include "SupervisedEngine.h"
+#include <csignal>
+#include <type_traits>
+
+namespace ac {
+
+SupervisedEngine::SupervisedEngine(std::string executable_path, WatchdogLimits limits):
+	executable_path_(std::move(executable_path)),
+	limits_(limits),
+	active_(),
+	spare_(),
+	setup_(),
+	cache_(),
+	latency_(),
+	position_(),
+	mutex_(),
+	wakeup_(),
+	deadline_(),
+	watchdog_()
+{
+	std::signal(SIGPIPE, SIG_IGN);
+	active_ = start_engine();
+	start_spare();
+	watchdog_ = std::thread([this]() { watch(); });
+}
+
+SupervisedEngine::~SupervisedEngine() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		shutting_down_ = true;
+	}
+	wakeup_.notify_one();
+	watchdog_.join();
+	if(spare_.valid()) {
+		try {
+			spare_.get();
+		} catch(...) {
+			// A spare that failed to start doesn't matter anymore.
+		}
+	}
+}
+
+std::unique_ptr<ChessEngine> SupervisedEngine::start_engine() const {
+	auto engine = std::make_unique<ChessEngine>(executable_path_.c_str());
+	engine->wait_ready();
+	return engine;
+}
+
+void SupervisedEngine::start_spare() {
+	spare_ = std::async(std::launch::async, [this]() { return start_engine(); });
+}
+
+void SupervisedEngine::replay_setup(ChessEngine& engine) const {
+	for(const auto& [name, step]: setup_) {
+		step(engine);
+	}
+	engine.set_analysis_cache(cache_);
+	engine.set_latency_stats(latency_);
+	if(position_) {
+		engine.set_position(position_->first, position_->second);
+	}
+}
+
+void SupervisedEngine::fail_over() {
+	std::unique_ptr<ChessEngine> replacement;
+	if(spare_.valid()) {
+		try {
+			replacement = spare_.get();
+		} catch(const std::exception&) {
+			// The spare never came up; fall through and start one synchronously.
+		}
+	}
+	if(not replacement) {
+		replacement = start_engine();
+	}
+	replay_setup(*replacement);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		active_->kill();
+		active_ = std::move(replacement);
+		killed_ = false;
+		++failovers_;
+	}
+	start_spare();
+}
+
+template <class Request>
+auto SupervisedEngine::supervised(std::optional<clock_type::duration> timeout, Request&& request) {
+	for(std::size_t attempt = 0u;; ++attempt) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			watched_ = active_.get();
+			killed_ = false;
+			if(timeout) {
+				deadline_ = clock_type::now() + *timeout;
+			}
+		}
+		wakeup_.notify_one();
+		auto disarm = [&]() {
+			std::lock_guard<std::mutex> lock(mutex_);
+			deadline_.reset();
+			watched_ = nullptr;
+			return killed_;
+		};
+		try {
+			if constexpr(std::is_void_v<std::invoke_result_t<Request&, ChessEngine&>>) {
+				request(*active_);
+				disarm();
+				return;
+			} else {
+				auto result = request(*active_);
+				disarm();
+				return result;
+			}
+		} catch(...) {
+			bool killed = disarm();
+			// Only failures caused by the engine dying are retried.
+			if((not killed and active_->running()) or attempt >= limits_.max_failovers) {
+				throw;
+			}
+		}
+		fail_over();
+	}
+}
+
+void SupervisedEngine::watch() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	while(not shutting_down_) {
+		if(not deadline_) {
+			wakeup_.wait(lock);
+			continue;
+		}
+		auto deadline = *deadline_;
+		wakeup_.wait_until(lock, deadline);
+		if(deadline_ and *deadline_ == deadline and clock_type::now() >= deadline and watched_) {
+			watched_->kill();
+			killed_ = true;
+			deadline_.reset();
+		}
+	}
+}
+
+std::optional<SupervisedEngine::clock_type::duration> SupervisedEngine::deadline_for(const UCIGoArgs& args) const {
+	if(args.infinite or args.ponder) {
+		return std::nullopt;
+	}
+	if(args.move_time) {
+		return *args.move_time + limits_.grace;
+	}
+	if(args.white_remaining_msec or args.black_remaining_msec) {
+		auto remaining = std::max(
+			args.white_remaining_msec.value_or(UCIGoArgs::msec_type(0)),
+			args.black_remaining_msec.value_or(UCIGoArgs::msec_type(0))
+		);
+		return remaining + limits_.grace;
+	}
+	return limits_.search_timeout + limits_.grace;
+}
+
+void SupervisedEngine::record_setup(std::string_view name, setup_step step) {
+	setup_[std::string(name)] = std::move(step);
+}
+
+const ChessEngine::option_map_type& SupervisedEngine::options() const {
+	return active_->options();
+}
+
+void SupervisedEngine::set_option(std::string_view name, uci::mp_int value) {
+	setup_step step = [name = std::string(name), value](ChessEngine& engine) { engine.set_option(name, value); };
+	supervised(limits_.ready_timeout, [&](ChessEngine& engine) { step(engine); engine.wait_ready(); });
+	record_setup(name, std::move(step));
+}
+
+void SupervisedEngine::set_option(std::string_view name, bool value) {
+	setup_step step = [name = std::string(name), value](ChessEngine& engine) { engine.set_option(name, value); };
+	supervised(limits_.ready_timeout, [&](ChessEngine& engine) { step(engine); engine.wait_ready(); });
+	record_setup(name, std::move(step));
+}
+
+void SupervisedEngine::set_option(std::string_view name) {
+	// Buttons are actions, not settings; they aren't replayed on a replacement engine.
+	supervised(limits_.ready_timeout, [&](ChessEngine& engine) { engine.set_option(name); engine.wait_ready(); });
+}
+
+void SupervisedEngine::set_option(std::string_view name, std::string_view value) {
+	setup_step step = [name = std::string(name), value = std::string(value)](ChessEngine& engine) {
+		engine.set_option(name, std::string_view(value));
+	};
+	supervised(limits_.ready_timeout, [&](ChessEngine& engine) { step(engine); engine.wait_ready(); });
+	record_setup(name, std::move(step));
+}
+
+void SupervisedEngine::set_position(const GameSnapshot& position, std::vector<PackedMove> moves) {
+	position_.emplace(position, std::move(moves));
+	active_->set_position(position_->first, position_->second);
+}
+
+void SupervisedEngine::set_analysis_cache(std::shared_ptr<AnalysisCache> cache) {
+	cache_ = std::move(cache);
+	active_->set_analysis_cache(cache_);
+}
+
+void SupervisedEngine::set_latency_stats(std::shared_ptr<EngineLatencyStats> stats) {
+	latency_ = std::move(stats);
+	active_->set_latency_stats(latency_);
+}
+
+void SupervisedEngine::wait_ready() {
+	supervised(limits_.ready_timeout, [](ChessEngine& engine) { engine.wait_ready(); });
+}
+
+SearchResult SupervisedEngine::go(const UCIGoArgs& args, const info_callback& on_info) {
+	return supervised(deadline_for(args), [&](ChessEngine& engine) { return engine.go(args, on_info); });
+}
+
+std::size_t SupervisedEngine::failover_count() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return failovers_;
+}
+
+} /* namespace ac */
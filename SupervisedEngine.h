@@ -0,0 +1,110 @@
+#ifndef AC_SUPERVISED_ENGINE_H
+#define AC_SUPERVISED_ENGINE_H
+
+#include "ChessEngine.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ac {
+
+struct WatchdogLimits {
+	using msec_type = std::chrono::milliseconds;
+
+	// Slack added on top of a search's own time limit before the engine is declared dead.
+	msec_type grace          = msec_type(2000);
+	// Deadline for 'isready'.
+	msec_type ready_timeout  = msec_type(5000);
+	// Deadline for searches that have no time limit of their own (depth, nodes, mate).
+	msec_type search_timeout = msec_type(120000);
+	// Number of times a single request is replayed on a fresh engine before giving up.
+	std::size_t max_failovers = 2u;
+};
+
+// A ChessEngine guarded by a watchdog thread.  Every request gets a deadline; if the engine
+// hasn't answered by then it is killed, a pre-started spare process takes its place, the
+// recorded options and position are replayed on it and the request is retried there.  A new
+// spare is then started in the background.
+//
+// The engine's output pipe breaking raises SIGPIPE, so constructing a SupervisedEngine
+// ignores SIGPIPE for the whole process.
+struct SupervisedEngine {
+	using info_callback = ChessEngine::info_callback;
+
+	explicit SupervisedEngine(std::string executable_path, WatchdogLimits limits = WatchdogLimits());
+	~SupervisedEngine();
+
+	SupervisedEngine(const SupervisedEngine&) = delete;
+	SupervisedEngine& operator=(const SupervisedEngine&) = delete;
+
+	const ChessEngine::option_map_type& options() const;
+
+	void set_option(std::string_view name, uci::mp_int value);
+	void set_option(std::string_view name, bool value);
+	void set_option(std::string_view name);
+	void set_option(std::string_view name, std::string_view value);
+
+	void set_position(const GameSnapshot& position, std::vector<PackedMove> moves = {});
+
+	void set_analysis_cache(std::shared_ptr<AnalysisCache> cache);
+	void set_latency_stats(std::shared_ptr<EngineLatencyStats> stats);
+
+	void wait_ready();
+
+	// Like ChessEngine::go().  Searches without a deadline ('infinite' or 'ponder') aren't
+	// watched.  If the request is retried after a failover, 'on_info' sees the lines of the
+	// aborted attempt followed by those of the retry.
+	SearchResult go(const UCIGoArgs& args, const info_callback& on_info = info_callback());
+
+	// Number of times the active engine has been replaced so far.
+	std::size_t failover_count() const;
+
+private:
+	using clock_type = std::chrono::steady_clock;
+	using setup_step = std::function<void(ChessEngine&)>;
+
+	std::unique_ptr<ChessEngine> start_engine() const;
+	void start_spare();
+	void fail_over();
+	void record_setup(std::string_view name, setup_step step);
+	void replay_setup(ChessEngine& engine) const;
+
+	std::optional<clock_type::duration> deadline_for(const UCIGoArgs& args) const;
+
+	// Run 'request' against the active engine under the watchdog, failing over and
+	// retrying if the engine dies.
+	template <class Request>
+	auto supervised(std::optional<clock_type::duration> timeout, Request&& request);
+
+	void watch();
+
+	std::string executable_path_;
+	WatchdogLimits limits_;
+	std::unique_ptr<ChessEngine> active_;
+	std::future<std::unique_ptr<ChessEngine>> spare_;
+	// Options in the order they were first set; setting an option again replaces its step.
+	tsl::ordered_map<std::string, setup_step> setup_;
+	std::shared_ptr<AnalysisCache> cache_;
+	std::shared_ptr<EngineLatencyStats> latency_;
+	std::optional<std::pair<GameSnapshot, std::vector<PackedMove>>> position_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable wakeup_;
+	std::optional<clock_type::time_point> deadline_;
+	ChessEngine* watched_ = nullptr;
+	bool killed_ = false;
+	bool shutting_down_ = false;
+	std::size_t failovers_ = 0u;
+	std::thread watchdog_;
+};
+
+} /* namespace ac */
+
+#endif /* AC_SUPERVISED_ENGINE_H */
@@ -0,0 +1,184 @@
+#include "Tablebase.h"
+#include "Stockfish/src/bitboard.h"
+#include "Stockfish/src/movegen.h"
+#include "Stockfish/src/position.h"
+#include "Stockfish/src/thread.h"
+#include "Stockfish/src/uci.h"
+#include "Stockfish/src/syzygy/tbprobe.h"
+#include <cstdlib>
+#include <mutex>
+
+namespace ac {
+
+namespace {
+
+std::once_flag stockfish_init_flag;
+
+// The parts of Stockfish's start-up that probing depends on: attack tables, Zobrist keys and
+// a thread for Position to count its nodes on.
+void init_stockfish() {
+	std::call_once(stockfish_init_flag, []() {
+		UCI::init(Options);
+		Bitboards::init();
+		Position::init();
+		Threads.set(1u);
+	});
+}
+
+// A Stockfish position set up from one of ours.
+struct ProbePosition {
+	explicit ProbePosition(const GameSnapshot& snapshot) {
+		pos.set(forsyth_edwards_encoding(snapshot), false, &state, Threads.main());
+	}
+
+	bool probeable() const {
+		return popcount(pos.pieces()) <= Tablebases::MaxCardinality and not pos.can_castle(ANY_CASTLING);
+	}
+
+	StateInfo state;
+	Position pos;
+};
+
+GameSnapshot snapshot_of(const CompressedBoard& board, ChessPieceColor to_move) {
+	GameSnapshot snapshot;
+	snapshot.board = board;
+	snapshot.temporal_state.active_color = to_move;
+	snapshot.temporal_state.castle_status = CastleStatus::None;
+	snapshot.temporal_state.en_passant_possible = false;
+	snapshot.temporal_state.en_passant_target = BoardPos::A1;
+	snapshot.temporal_state.halfmove_clock = 0u;
+	snapshot.temporal_state.fullmove_number = 1u;
+	return snapshot;
+}
+
+std::optional<TablebaseWDL> probe_wdl(Position& pos) {
+	Tablebases::ProbeState result;
+	auto wdl = Tablebases::probe_wdl(pos, &result);
+	if(result == Tablebases::FAIL) {
+		return std::nullopt;
+	}
+	return static_cast<TablebaseWDL>(wdl);
+}
+
+std::optional<int> probe_dtz(Position& pos) {
+	Tablebases::ProbeState result;
+	auto dtz = Tablebases::probe_dtz(pos, &result);
+	if(result == Tablebases::FAIL) {
+		return std::nullopt;
+	}
+	return dtz;
+}
+
+BoardPos board_pos(::Square sq) {
+	return make_board_pos(
+		col_from_index(static_cast<std::size_t>(file_of(sq))),
+		row_from_index(static_cast<std::size_t>(rank_of(sq)))
+	);
+}
+
+PackedMove packed_move(::Move m) {
+	auto from = board_pos(from_sq(m));
+	auto to = board_pos(to_sq(m));
+	std::optional<ChessPieceKind> promotion;
+	if(type_of(m) == CASTLING) {
+		// Stockfish encodes castling as the king capturing its own rook.
+		to = make_board_pos(to_sq(m) > from_sq(m) ? 'G'_col : 'C'_col, row(from));
+	} else if(type_of(m) == PROMOTION) {
+		promotion = static_cast<ChessPieceKind>(promotion_type(m) - PAWN);
+	}
+	return PackedMove(from, to, promotion);
+}
+
+} /* namespace */
+
+SyzygyTablebases::SyzygyTablebases(const std::string& paths) {
+	init_stockfish();
+	Tablebases::init(paths);
+}
+
+std::size_t SyzygyTablebases::max_pieces() const {
+	return static_cast<std::size_t>(Tablebases::MaxCardinality);
+}
+
+bool SyzygyTablebases::covers(MaterialSignature material) const {
+	return material.piece_count() <= max_pieces();
+}
+
+std::optional<TablebaseWDL> SyzygyTablebases::probe_wdl(const GameSnapshot& snapshot) const {
+	ProbePosition p(snapshot);
+	if(not p.probeable()) {
+		return std::nullopt;
+	}
+	return ac::probe_wdl(p.pos);
+}
+
+std::optional<int> SyzygyTablebases::probe_dtz(const GameSnapshot& snapshot) const {
+	ProbePosition p(snapshot);
+	if(not p.probeable()) {
+		return std::nullopt;
+	}
+	return ac::probe_dtz(p.pos);
+}
+
+std::optional<TablebaseWDL> SyzygyTablebases::probe_wdl(const CompressedBoard& board, ChessPieceColor to_move) const {
+	return probe_wdl(snapshot_of(board, to_move));
+}
+
+std::optional<int> SyzygyTablebases::probe_dtz(const CompressedBoard& board, ChessPieceColor to_move) const {
+	return probe_dtz(snapshot_of(board, to_move));
+}
+
+std::optional<TablebaseHint> SyzygyTablebases::best_move(const GameSnapshot& snapshot) const {
+	ProbePosition p(snapshot);
+	if(not p.probeable()) {
+		return std::nullopt;
+	}
+	auto& pos = p.pos;
+	std::optional<TablebaseHint> best;
+	// Ordering within an outcome: mate first, then the shortest road to a zeroing move when
+	// winning, the longest when losing.
+	int best_rank = 0;
+	for(const auto& ext: MoveList<LEGAL>(pos)) {
+		::Move m = ext;
+		StateInfo st;
+		pos.do_move(m, st);
+		auto opponent_wdl = ac::probe_wdl(pos);
+		auto zeroing = pos.rule50_count() == 0;
+		auto dtz = (zeroing or not opponent_wdl) ? std::optional<int>(0) : ac::probe_dtz(pos);
+		auto mate = pos.checkers() and MoveList<LEGAL>(pos).size() == 0u;
+		pos.undo_move(m);
+		if(not opponent_wdl or not dtz) {
+			return std::nullopt;
+		}
+		auto wdl = static_cast<TablebaseWDL>(-static_cast<int>(*opponent_wdl));
+		auto distance = std::abs(*dtz);
+		int rank = 0;
+		if(mate) {
+			rank = 1024;
+		} else if(wdl > TablebaseWDL::Draw) {
+			rank = -distance;
+		} else if(wdl < TablebaseWDL::Draw) {
+			rank = distance;
+		}
+		if(not best or wdl > best->wdl or (wdl == best->wdl and rank > best_rank)) {
+			best = TablebaseHint{packed_move(m), wdl, distance};
+			best_rank = rank;
+		}
+	}
+	return best;
+}
+
+std::optional<GameResult> SyzygyTablebases::adjudicate(const GameSnapshot& snapshot) const {
+	auto wdl = probe_wdl(snapshot);
+	if(not wdl) {
+		return std::nullopt;
+	}
+	if(*wdl == TablebaseWDL::Win or *wdl == TablebaseWDL::Loss) {
+		auto to_move_wins = *wdl == TablebaseWDL::Win;
+		auto white_to_move = snapshot.temporal_state.active_color == ChessPieceColor::White;
+		return to_move_wins == white_to_move ? GameResult::WhiteWins : GameResult::BlackWins;
+	}
+	return GameResult::Draw;
+}
+
+} /* namespace ac */
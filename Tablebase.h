@@ -0,0 +1,77 @@
+#ifndef AC_TABLEBASE_H
+#define AC_TABLEBASE_H
+
+#include "Board.h"
+#include "ChessPiece.h"
+#include "GameArchive.h"
+#include "GameSnapshot.h"
+#include "MaterialSignature.h"
+#include "Move.h"
+#include <optional>
+#include <string>
+
+namespace ac {
+
+// Win/draw/loss from the point of view of the side to move.  Cursed wins and blessed losses
+// are wins and losses that the fifty-move rule turns into draws.
+enum class TablebaseWDL: signed char {
+	Loss        = -2,
+	BlessedLoss = -1,
+	Draw        =  0,
+	CursedWin   =  1,
+	Win         =  2
+};
+
+struct TablebaseHint {
+	PackedMove move;
+	// Outcome after 'move', from the point of view of the side that played it.
+	TablebaseWDL wdl;
+	// Plies until the next capture or pawn move along the tablebase line, from the position
+	// after 'move'; zero if 'move' itself resets the fifty-move counter.
+	int dtz;
+};
+
+// In-process Syzygy probing through the vendored Stockfish's tbprobe, so endgame positions
+// can be scored and adjudicated without starting an engine.
+//
+// Stockfish keeps its tables in global state: constructing a SyzygyTablebases (re)loads the
+// process-wide tables, so there should only be one at a time and it must not be constructed
+// while another thread is probing.  Probing itself is thread-safe.
+struct SyzygyTablebases {
+	// 'paths' is a list of directories separated by ':' (';' on Windows), as for the
+	// 'SyzygyPath' UCI option.
+	explicit SyzygyTablebases(const std::string& paths);
+
+	SyzygyTablebases(const SyzygyTablebases&) = delete;
+	SyzygyTablebases& operator=(const SyzygyTablebases&) = delete;
+
+	// Largest number of pieces (kings included) covered by the loaded tables; zero if none
+	// were found.
+	std::size_t max_pieces() const;
+
+	// Whether positions with 'material' are few enough pieces to be covered, without looking
+	// at the board; for deciding between tablebase and engine.
+	bool covers(MaterialSignature material) const;
+
+	// Each probe returns std::nullopt if the position has too many pieces, still has castling
+	// rights, or its table is missing.
+	std::optional<TablebaseWDL> probe_wdl(const GameSnapshot& snapshot) const;
+	std::optional<int> probe_dtz(const GameSnapshot& snapshot) const;
+
+	// Same, for 'board' with 'to_move' to play and no castling or en passant possible.
+	std::optional<TablebaseWDL> probe_wdl(const CompressedBoard& board, ChessPieceColor to_move) const;
+	std::optional<int> probe_dtz(const CompressedBoard& board, ChessPieceColor to_move) const;
+
+	// The move that keeps the best outcome for the side to move: the quickest win, the most
+	// stubborn loss, or a move that holds the draw.  Std::nullopt if there is no legal move
+	// or the position can't be probed.
+	std::optional<TablebaseHint> best_move(const GameSnapshot& snapshot) const;
+
+	// The result the game will have with best play, taking the fifty-move rule into account
+	// through the cursed/blessed distinction only.  Std::nullopt if the position can't be probed.
+	std::optional<GameResult> adjudicate(const GameSnapshot& snapshot) const;
+};
+
+} /* namespace ac */
+
+#endif /* AC_TABLEBASE_H */
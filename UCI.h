@@ -4,8 +4,12 @@
 #include <utility>
 #include <string_view>
 #include <variant>
+#include <vector>
+#include <optional>
+#include <cstdint>
 #include <boost/multiprecision/cpp_int.hpp>
 #include "tsl/ordered_set.h"
+#include "Move.h"
 
 namespace ac::uci {
 
@@ -200,6 +204,62 @@ constexpr decltype(auto) visit(Visitor&& visitor, Option& opt) {
 	return std::visit(std::forward<Visitor>(visitor), static_cast<Option::base_type&>(opt));
 }
 
+enum class ScoreKind: unsigned char {
+	Centipawns,
+	Mate
+};
+
+enum class ScoreBound: unsigned char {
+	Exact,
+	Lower,
+	Upper
+};
+
+struct Score {
+	ScoreKind kind;
+	// Centipawns, or moves until mate (negative if the engine is being mated).
+	std::int32_t value;
+
+	friend constexpr bool operator==(Score l, Score r) {
+		return l.kind == r.kind and l.value == r.value;
+	}
+
+	friend constexpr bool operator!=(Score l, Score r) {
+		return not (l == r);
+	}
+};
+
+// The fields of an 'info' line that we care about.  Anything else the engine reports is skipped.
+struct InfoLine {
+	std::optional<std::size_t> depth;
+	std::optional<std::size_t> seldepth;
+	std::optional<std::size_t> multipv;
+	std::optional<Score> score;
+	ScoreBound bound = ScoreBound::Exact;
+	std::optional<std::uint64_t> nodes;
+	std::optional<std::uint64_t> nps;
+	std::optional<std::uint64_t> time_msec;
+	std::vector<PackedMove> pv;
+};
+
+// Which line of a MultiPV search 'info' reports on, counting from 0; lines without 'multipv'
+// are about the best line.  std::nullopt for 'multipv 0', which no line can be.
+inline std::optional<std::size_t> pv_index(const InfoLine& info) {
+	if(not info.multipv) {
+		return 0u;
+	}
+	if(*info.multipv == 0u) {
+		return std::nullopt;
+	}
+	return *info.multipv - 1u;
+}
+
+struct BestMove {
+	// Empty if the engine answered 'bestmove (none)'.
+	std::optional<PackedMove> move;
+	std::optional<PackedMove> ponder;
+};
+
 } /* namespace ac::uci */
 
 #endif /* AC_UCI_H */
@@ -0,0 +1,94 @@
+#ifndef AC_ZOBRIST_H
+#define AC_ZOBRIST_H
+
+#include "ChessPiece.h"
+#include "Board.h"
+#include "GameSnapshot.h"
+#include <array>
+#include <cstdint>
+
+namespace ac {
+
+namespace detail {
+
+constexpr std::uint64_t splitmix64(std::uint64_t& state) {
+	state += 0x9E3779B97F4A7C15u;
+	auto z = state;
+	z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9u;
+	z = (z ^ (z >> 27u)) * 0x94D049BB133111EBu;
+	return z ^ (z >> 31u);
+}
+
+struct ZobristKeys {
+	std::array<std::array<std::uint64_t, 64u>, 12u> pieces = {};
+	std::array<std::uint64_t, 16u> castle_status = {};
+	std::array<std::uint64_t, 8u> en_passant_col = {};
+	std::uint64_t black_to_move = 0u;
+};
+
+constexpr ZobristKeys make_zobrist_keys() {
+	ZobristKeys keys;
+	std::uint64_t state = 0x5A0B1257u;
+	for(auto& piece_keys: keys.pieces) {
+		for(auto& key: piece_keys) {
+			key = splitmix64(state);
+		}
+	}
+	for(auto& key: keys.castle_status) {
+		key = splitmix64(state);
+	}
+	for(auto& key: keys.en_passant_col) {
+		key = splitmix64(state);
+	}
+	keys.black_to_move = splitmix64(state);
+	return keys;
+}
+
+inline constexpr ZobristKeys zobrist_keys = make_zobrist_keys();
+
+} /* namespace detail */
+
+constexpr std::uint64_t zobrist_key(ChessPiece piece, BoardPos pos) {
+	return detail::zobrist_keys.pieces[index(piece)][index(pos)];
+}
+
+constexpr std::uint64_t zobrist_key(CastleStatus status) {
+	return detail::zobrist_keys.castle_status[static_cast<unsigned char>(status)];
+}
+
+constexpr std::uint64_t zobrist_en_passant_key(BoardPos target) {
+	return detail::zobrist_keys.en_passant_col[index(col(target))];
+}
+
+constexpr std::uint64_t zobrist_black_to_move_key() {
+	return detail::zobrist_keys.black_to_move;
+}
+
+constexpr std::uint64_t zobrist_hash(const CompressedBoard& board) {
+	std::uint64_t hash = 0u;
+	for(auto pos: each_position) {
+		if(auto piece = board[pos]) {
+			hash ^= zobrist_key(*piece, pos);
+		}
+	}
+	return hash;
+}
+
+// Hashes everything that identifies a position for search purposes; the halfmove clock and
+// fullmove number are deliberately left out.
+constexpr std::uint64_t zobrist_hash(const GameSnapshot& snapshot) {
+	const auto& state = snapshot.temporal_state;
+	auto hash = zobrist_hash(snapshot.board);
+	hash ^= zobrist_key(state.castle_status);
+	if(state.en_passant_possible) {
+		hash ^= zobrist_en_passant_key(state.en_passant_target);
+	}
+	if(state.active_color == ChessPieceColor::Black) {
+		hash ^= zobrist_black_to_move_key();
+	}
+	return hash;
+}
+
+} /* namespace ac */
+
+#endif /* AC_ZOBRIST_H */
@@ -0,0 +1,237 @@
+#ifndef AC_ALGEBRAIC_NOTATION_H
+#define AC_ALGEBRAIC_NOTATION_H
+
+#include "attack_sets.h"
+#include "Board.h"
+#include "GameSnapshot.h"
+#include "Move.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace ac {
+
+namespace detail {
+
+constexpr char file_char(BoardPos pos) {
+	return static_cast<char>('a' + index(col(pos)));
+}
+
+constexpr char rank_char(BoardPos pos) {
+	return static_cast<char>('1' + index(row(pos)));
+}
+
+constexpr std::optional<ChessPieceKind> san_piece_kind(char c) {
+	switch(c) {
+	case 'N': return ChessPieceKind::Knight;
+	case 'B': return ChessPieceKind::Bishop;
+	case 'R': return ChessPieceKind::Rook;
+	case 'Q': return ChessPieceKind::Queen;
+	case 'K': return ChessPieceKind::King;
+	default:  return std::nullopt;
+	}
+}
+
+constexpr bool is_castle(PackedMove mv, ChessPieceKind moved_kind) {
+	auto from = index(col(mv.start_position()));
+	auto to = index(col(mv.end_position()));
+	return moved_kind == ChessPieceKind::King and (from == to + 2u or to == from + 2u);
+}
+
+} /* namespace detail */
+
+// Standard Algebraic Notation for the legal move 'mv' in 'snapshot', with a '+' or '#' suffix
+// for check or mate.  Disambiguation only considers pieces that could legally make the same
+// move, as SAN requires.
+constexpr MoveText standard_algebraic_notation(const GameSnapshot& snapshot, PackedMove mv) {
+	auto board = snapshot.board.decompressed();
+	auto from = mv.start_position();
+	auto to = mv.end_position();
+	auto piece = board[from];
+	assert(piece);
+	auto moved_kind = kind(*piece);
+	MoveText text;
+	if(detail::is_castle(mv, moved_kind)) {
+		text.append(col(to) == 'G'_col ? "O-O" : "O-O-O");
+	} else if(moved_kind == ChessPieceKind::Pawn) {
+		if(col(from) != col(to)) {
+			text.push_back(detail::file_char(from));
+			text.push_back('x');
+		}
+		text.push_back(detail::file_char(to));
+		text.push_back(detail::rank_char(to));
+		if(auto promotion = mv.promotion()) {
+			text.push_back('=');
+			text.append(name(*promotion));
+		}
+	} else {
+		text.append(name(moved_kind));
+		auto rivals = piece_attacks(moved_kind, to, board.all_positions()) & board.positions(*piece);
+		rivals[from] = false;
+		bool any_rival = false;
+		bool shares_col = false;
+		bool shares_row = false;
+		for(auto p: rivals.positions()) {
+			if(not leaves_king_safe(board, PackedMove(p, to))) {
+				continue;
+			}
+			any_rival = true;
+			shares_col = shares_col or col(p) == col(from);
+			shares_row = shares_row or row(p) == row(from);
+		}
+		if(any_rival) {
+			if(not shares_col) {
+				text.push_back(detail::file_char(from));
+			} else if(not shares_row) {
+				text.push_back(detail::rank_char(from));
+			} else {
+				text.push_back(detail::file_char(from));
+				text.push_back(detail::rank_char(from));
+			}
+		}
+		if(board[to]) {
+			text.push_back('x');
+		}
+		text.push_back(detail::file_char(to));
+		text.push_back(detail::rank_char(to));
+	}
+	auto after = board_after(board, mv);
+	auto opponent = opposite_color(color(*piece));
+	if(in_check(after, opponent)) {
+		auto next = snapshot;
+		apply_move(next, mv);
+		text.push_back(has_legal_move(after, next.temporal_state) ? '+' : '#');
+	}
+	return text;
+}
+
+// The legal move in 'snapshot' described by the SAN string 'san', or std::nullopt if it is
+// malformed, illegal or ambiguous.  Trailing check, mate and annotation marks ("+", "#", "!?"
+// etc.) are ignored, "0-0" is accepted for "O-O" and the '=' before a promotion is optional.
+constexpr std::optional<PackedMove> decode_standard_algebraic_notation(const GameSnapshot& snapshot, std::string_view san) {
+	auto last = san.find_last_not_of("+#!?");
+	if(last == std::string_view::npos) {
+		return std::nullopt;
+	}
+	san = san.substr(0u, last + 1u);
+	auto board = snapshot.board.decompressed();
+	const auto& state = snapshot.temporal_state;
+	auto c = state.active_color;
+	if(san == "O-O" or san == "0-0" or san == "O-O-O" or san == "0-0-0") {
+		auto kingside = san.size() == 3u;
+		if(not castle_is_legal(board, state, kingside)) {
+			return std::nullopt;
+		}
+		auto home = c == ChessPieceColor::White ? 1_row : 8_row;
+		return PackedMove(make_board_pos('E'_col, home), make_board_pos(kingside ? 'G'_col : 'C'_col, home));
+	}
+	auto moved_kind = ChessPieceKind::Pawn;
+	if(auto k = san.empty() ? std::nullopt : detail::san_piece_kind(san.front())) {
+		moved_kind = *k;
+		san.remove_prefix(1u);
+	}
+	std::optional<ChessPieceKind> promotion;
+	if(moved_kind == ChessPieceKind::Pawn and san.size() > 2u) {
+		promotion = detail::san_piece_kind(san.back());
+		if(promotion) {
+			if(*promotion == ChessPieceKind::King) {
+				return std::nullopt;
+			}
+			san.remove_suffix(1u);
+			if(san.back() == '=') {
+				san.remove_suffix(1u);
+			}
+		}
+	}
+	if(san.size() < 2u) {
+		return std::nullopt;
+	}
+	auto file = san[san.size() - 2u];
+	auto rank = san[san.size() - 1u];
+	if(file < 'a' or file > 'h' or rank < '1' or rank > '8') {
+		return std::nullopt;
+	}
+	auto to = make_board_pos(col_from_index(file - 'a'), row_from_index(rank - '1'));
+	san.remove_suffix(2u);
+	if(not san.empty() and san.back() == 'x') {
+		san.remove_suffix(1u);
+	}
+	std::optional<BoardCol> from_col;
+	std::optional<BoardRow> from_row;
+	for(char ch: san) {
+		if(ch >= 'a' and ch <= 'h' and not from_col and not from_row) {
+			from_col = col_from_index(ch - 'a');
+		} else if(ch >= '1' and ch <= '8' and not from_row) {
+			from_row = row_from_index(ch - '1');
+		} else {
+			return std::nullopt;
+		}
+	}
+	auto target = board[to];
+	if(target and color(*target) == c) {
+		return std::nullopt;
+	}
+	BitBoard candidates;
+	if(moved_kind == ChessPieceKind::Pawn) {
+		auto last_row = c == ChessPieceColor::White ? 8_row : 1_row;
+		if((row(to) == last_row) != promotion.has_value()) {
+			return std::nullopt;
+		}
+		auto pawns = board.positions(c + ChessPieceKind::Pawn);
+		if(from_col) {
+			// Pawn captures always name the pawn's file.
+			auto en_passant = state.en_passant_possible and state.en_passant_target == to;
+			if(not target and not en_passant) {
+				return std::nullopt;
+			}
+			candidates = pawn_attacks(opposite_color(c), to) & pawns;
+		} else if(not target) {
+			auto back = c == ChessPieceColor::White ? -1 : 1;
+			auto r = static_cast<int>(index(row(to))) + back;
+			if(r >= 0 and r < 8) {
+				auto one = make_board_pos(col(to), row_from_index(static_cast<std::size_t>(r)));
+				auto double_step_row = c == ChessPieceColor::White ? 4_row : 5_row;
+				if(pawns[one]) {
+					candidates[one] = true;
+				} else if(not board[one] and row(to) == double_step_row) {
+					auto two = make_board_pos(col(to), row_from_index(static_cast<std::size_t>(r + back)));
+					if(pawns[two]) {
+						candidates[two] = true;
+					}
+				}
+			}
+		}
+	} else {
+		candidates = piece_attacks(moved_kind, to, board.all_positions()) & board.positions(c + moved_kind);
+	}
+	std::optional<PackedMove> match;
+	for(auto from: candidates.positions()) {
+		if((from_col and col(from) != *from_col) or (from_row and row(from) != *from_row)) {
+			continue;
+		}
+		PackedMove mv(from, to, promotion);
+		if(not leaves_king_safe(board, mv)) {
+			continue;
+		}
+		if(match) {
+			// Ambiguous.
+			return std::nullopt;
+		}
+		match = mv;
+	}
+	return match;
+}
+
+// Parse a UCI move ("e2e4", "e7e8q", "e1g1") and check that it is legal in 'snapshot'.
+constexpr std::optional<PackedMove> decode_long_algebraic_notation(const GameSnapshot& snapshot, std::string_view lan) {
+	auto mv = decode_long_algebraic_notation(lan);
+	if(not mv or not is_legal(snapshot.board.decompressed(), snapshot.temporal_state, *mv)) {
+		return std::nullopt;
+	}
+	return mv;
+}
+
+} /* namespace ac */
+
+#endif /* AC_ALGEBRAIC_NOTATION_H */
@@ -0,0 +1,369 @@
+#ifndef AC_ATTACK_SETS_H
+#define AC_ATTACK_SETS_H
+
+#include "BitBoard.h"
+#include "Board.h"
+#include "ChessPiece.h"
+#include "GameSnapshot.h"
+#include "Move.h"
+#include <array>
+#include <cstdint>
+#include <utility>
+
+namespace ac {
+
+namespace detail {
+
+constexpr bool on_board(int c, int r) {
+	return c >= 0 and c < 8 and r >= 0 and r < 8;
+}
+
+constexpr std::uint64_t square_bit(int c, int r) {
+	return std::uint64_t(1u) << static_cast<unsigned>(c * 8 + r);
+}
+
+// For each square, the squares reached by taking one of 'steps' (column, row offsets) from it.
+template <std::size_t N>
+constexpr std::array<std::uint64_t, 64u> step_attack_table(const std::array<std::pair<int, int>, N>& steps) {
+	std::array<std::uint64_t, 64u> table = {};
+	for(std::size_t i = 0u; i < 64u; ++i) {
+		auto c = static_cast<int>(i / 8u);
+		auto r = static_cast<int>(i % 8u);
+		for(const auto& step: steps) {
+			if(on_board(c + step.first, r + step.second)) {
+				table[i] |= square_bit(c + step.first, r + step.second);
+			}
+		}
+	}
+	return table;
+}
+
+inline constexpr auto knight_attack_table = step_attack_table<8u>({{
+	{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
+}});
+
+inline constexpr auto king_attack_table = step_attack_table<8u>({{
+	{0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}
+}});
+
+inline constexpr auto white_pawn_attack_table = step_attack_table<2u>({{{-1, 1}, {1, 1}}});
+inline constexpr auto black_pawn_attack_table = step_attack_table<2u>({{{-1, -1}, {1, -1}}});
+
+// Squares along one direction from 'pos', up to and including the first occupied one.
+constexpr std::uint64_t ray_attacks(BoardPos pos, std::uint64_t occupied, int dc, int dr) {
+	std::uint64_t attacks = 0u;
+	auto c = static_cast<int>(index(col(pos))) + dc;
+	auto r = static_cast<int>(index(row(pos))) + dr;
+	for(; on_board(c, r); c += dc, r += dr) {
+		auto bit = square_bit(c, r);
+		attacks |= bit;
+		if(occupied & bit) {
+			break;
+		}
+	}
+	return attacks;
+}
+
+} /* namespace detail */
+
+constexpr BitBoard knight_attacks(BoardPos pos) {
+	return BitBoard::from_bits(detail::knight_attack_table[index(pos)]);
+}
+
+constexpr BitBoard king_attacks(BoardPos pos) {
+	return BitBoard::from_bits(detail::king_attack_table[index(pos)]);
+}
+
+// Squares a pawn of color 'c' standing on 'pos' captures on.
+constexpr BitBoard pawn_attacks(ChessPieceColor c, BoardPos pos) {
+	if(c == ChessPieceColor::White) {
+		return BitBoard::from_bits(detail::white_pawn_attack_table[index(pos)]);
+	} else {
+		return BitBoard::from_bits(detail::black_pawn_attack_table[index(pos)]);
+	}
+}
+
+constexpr BitBoard bishop_attacks(BoardPos pos, BitBoard occupied) {
+	auto occ = occupied.bits();
+	return BitBoard::from_bits(
+		detail::ray_attacks(pos, occ,  1,  1)
+		| detail::ray_attacks(pos, occ,  1, -1)
+		| detail::ray_attacks(pos, occ, -1,  1)
+		| detail::ray_attacks(pos, occ, -1, -1)
+	);
+}
+
+constexpr BitBoard rook_attacks(BoardPos pos, BitBoard occupied) {
+	auto occ = occupied.bits();
+	return BitBoard::from_bits(
+		detail::ray_attacks(pos, occ,  0,  1)
+		| detail::ray_attacks(pos, occ,  0, -1)
+		| detail::ray_attacks(pos, occ,  1,  0)
+		| detail::ray_attacks(pos, occ, -1,  0)
+	);
+}
+
+constexpr BitBoard queen_attacks(BoardPos pos, BitBoard occupied) {
+	return bishop_attacks(pos, occupied) | rook_attacks(pos, occupied);
+}
+
+// Squares attacked by a piece of kind 'k' (anything but a pawn) standing on 'pos'.
+constexpr BitBoard piece_attacks(ChessPieceKind k, BoardPos pos, BitBoard occupied) {
+	switch(k) {
+	case ChessPieceKind::Knight: return knight_attacks(pos);
+	case ChessPieceKind::Bishop: return bishop_attacks(pos, occupied);
+	case ChessPieceKind::Rook:   return rook_attacks(pos, occupied);
+	case ChessPieceKind::Queen:  return queen_attacks(pos, occupied);
+	case ChessPieceKind::King:   return king_attacks(pos);
+	default:
+		assert(!"Pawn attacks depend on the pawn's color.");
+		return BitBoard();
+	}
+}
+
+// Positions of the pieces of color 'by' that attack 'target', with sliding pieces blocked by
+// 'occupied'.
+constexpr BitBoard attackers_of(const Board& board, BoardPos target, ChessPieceColor by, BitBoard occupied) {
+	auto queens = board.positions(by + ChessPieceKind::Queen);
+	return (pawn_attacks(opposite_color(by), target) & board.positions(by + ChessPieceKind::Pawn))
+		| (knight_attacks(target) & board.positions(by + ChessPieceKind::Knight))
+		| (king_attacks(target) & board.positions(by + ChessPieceKind::King))
+		| (bishop_attacks(target, occupied) & (board.positions(by + ChessPieceKind::Bishop) | queens))
+		| (rook_attacks(target, occupied) & (board.positions(by + ChessPieceKind::Rook) | queens));
+}
+
+constexpr bool is_attacked(const Board& board, BoardPos target, ChessPieceColor by) {
+	return attackers_of(board, target, by, board.all_positions()).any();
+}
+
+constexpr bool in_check(const Board& board, ChessPieceColor c) {
+	auto kings = board.positions(c + ChessPieceKind::King);
+	if(kings.none()) {
+		return false;
+	}
+	return is_attacked(board, *kings.positions().begin(), opposite_color(c));
+}
+
+// The piece placement after playing 'mv', which must move a piece.  Castling (the king's
+// two-square move) also moves the rook and en passant removes the captured pawn.
+constexpr Board board_after(const Board& board, PackedMove mv) {
+	auto after = board;
+	auto from = mv.start_position();
+	auto to = mv.end_position();
+	auto piece = board[from];
+	assert(piece);
+	auto moved_kind = kind(*piece);
+	if(moved_kind == ChessPieceKind::Pawn and col(from) != col(to) and not board[to]) {
+		after[make_board_pos(col(to), row(from))] = std::nullopt;
+	} else if(moved_kind == ChessPieceKind::King and (index(col(from)) == index(col(to)) + 2u or index(col(to)) == index(col(from)) + 2u)) {
+		auto kingside = col(to) == 'G'_col;
+		after[make_board_pos(kingside ? 'H'_col : 'A'_col, row(from))] = std::nullopt;
+		after[make_board_pos(kingside ? 'F'_col : 'D'_col, row(from))] = color(*piece) + ChessPieceKind::Rook;
+	}
+	after[from] = std::nullopt;
+	if(auto promotion = mv.promotion()) {
+		after[to] = color(*piece) + *promotion;
+	} else {
+		after[to] = *piece;
+	}
+	return after;
+}
+
+// Whether a pseudo-legal move leaves the mover's own king out of check.  For castling this
+// only checks the king's destination; see castle_is_legal().  The board isn't copied: the
+// move is played on the occupancy alone and pieces it captures are masked out.
+constexpr bool leaves_king_safe(const Board& board, PackedMove mv) {
+	auto from = mv.start_position();
+	auto to = mv.end_position();
+	auto piece = board[from];
+	assert(piece);
+	auto c = color(*piece);
+	auto moved_kind = kind(*piece);
+	auto square = [](BoardPos pos) {
+		return BitBoard::from_bits(std::uint64_t(1u) << index(pos));
+	};
+	auto occupied = (board.all_positions() & ~square(from)) | square(to);
+	auto removed = square(to);
+	auto king = to;
+	if(moved_kind != ChessPieceKind::King) {
+		auto kings = board.positions(c + ChessPieceKind::King);
+		if(kings.none()) {
+			return true;
+		}
+		king = *kings.positions().begin();
+	}
+	if(moved_kind == ChessPieceKind::Pawn and col(from) != col(to) and not board[to]) {
+		auto victim = square(make_board_pos(col(to), row(from)));
+		occupied &= ~victim;
+		removed |= victim;
+	} else if(moved_kind == ChessPieceKind::King and (index(col(from)) == index(col(to)) + 2u or index(col(to)) == index(col(from)) + 2u)) {
+		auto kingside = col(to) == 'G'_col;
+		occupied &= ~square(make_board_pos(kingside ? 'H'_col : 'A'_col, row(from)));
+		occupied |= square(make_board_pos(kingside ? 'F'_col : 'D'_col, row(from)));
+	}
+	return (attackers_of(board, king, opposite_color(c), occupied) & ~removed).none();
+}
+
+namespace detail {
+
+// castle_is_legal() for 'C' on the given side.  The move generator calls this directly, as
+// it already knows the side to move and the occupancy.
+template <ChessPieceColor C, bool Kingside>
+constexpr bool castle_is_legal(const Board& board, const TemporalGameState& state, BitBoard occupied) {
+	constexpr auto home = C == ChessPieceColor::White ? 1_row : 8_row;
+	constexpr CastleStatus right = C == ChessPieceColor::White
+		? (Kingside ? CastleStatus::WhiteKingside : CastleStatus::WhiteQueenside)
+		: (Kingside ? CastleStatus::BlackKingside : CastleStatus::BlackQueenside);
+	constexpr auto king_from = make_board_pos('E'_col, home);
+	constexpr auto rook_from = make_board_pos(Kingside ? 'H'_col : 'A'_col, home);
+	// Columns strictly between king and rook, and columns the king stands on or crosses.
+	constexpr std::size_t empty_first = Kingside ? 5u : 1u;
+	constexpr std::size_t empty_last  = Kingside ? 6u : 3u;
+	constexpr std::size_t safe_first  = Kingside ? 4u : 2u;
+	constexpr std::size_t safe_last   = Kingside ? 6u : 4u;
+	if((state.castle_status & right) == CastleStatus::None) {
+		return false;
+	}
+	if(not board.positions(C + ChessPieceKind::King)[king_from] or not board.positions(C + ChessPieceKind::Rook)[rook_from]) {
+		return false;
+	}
+	for(auto i = empty_first; i <= empty_last; ++i) {
+		if(occupied[make_board_pos(col_from_index(i), home)]) {
+			return false;
+		}
+	}
+	for(auto i = safe_first; i <= safe_last; ++i) {
+		if(attackers_of(board, make_board_pos(col_from_index(i), home), opposite_color(C), occupied).any()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} /* namespace detail */
+
+// Whether the side to move may castle on the given side right now: it still has the right,
+// the squares between king and rook are empty and the king doesn't start on, pass through or
+// land on an attacked square.
+constexpr bool castle_is_legal(const Board& board, const TemporalGameState& state, bool kingside) {
+	auto occupied = board.all_positions();
+	if(state.active_color == ChessPieceColor::White) {
+		return kingside
+			? detail::castle_is_legal<ChessPieceColor::White, true>(board, state, occupied)
+			: detail::castle_is_legal<ChessPieceColor::White, false>(board, state, occupied);
+	}
+	return kingside
+		? detail::castle_is_legal<ChessPieceColor::Black, true>(board, state, occupied)
+		: detail::castle_is_legal<ChessPieceColor::Black, false>(board, state, occupied);
+}
+
+// Whether 'mv' is a legal move for the side to move.  Castling must be given as the king's
+// two-square move.
+constexpr bool is_legal(const Board& board, const TemporalGameState& state, PackedMove mv) {
+	auto c = state.active_color;
+	auto from = mv.start_position();
+	auto to = mv.end_position();
+	auto piece = board[from];
+	if(not piece or color(*piece) != c or from == to) {
+		return false;
+	}
+	auto target = board[to];
+	if(target and color(*target) == c) {
+		return false;
+	}
+	auto moved_kind = kind(*piece);
+	if(moved_kind == ChessPieceKind::Pawn) {
+		auto last_row = c == ChessPieceColor::White ? 8_row : 1_row;
+		if((row(to) == last_row) != mv.promotion().has_value()) {
+			return false;
+		}
+		if(col(from) != col(to)) {
+			auto en_passant = state.en_passant_possible and state.en_passant_target == to;
+			if(not pawn_attacks(c, from)[to] or (not target and not en_passant)) {
+				return false;
+			}
+		} else {
+			auto forward = c == ChessPieceColor::White ? 1 : -1;
+			auto r_from = static_cast<int>(index(row(from)));
+			auto r_to = static_cast<int>(index(row(to)));
+			auto start_row = c == ChessPieceColor::White ? 2_row : 7_row;
+			if(target) {
+				return false;
+			}
+			if(r_to == r_from + 2 * forward and row(from) == start_row) {
+				if(board[make_board_pos(col(from), row_from_index(static_cast<std::size_t>(r_from + forward)))]) {
+					return false;
+				}
+			} else if(r_to != r_from + forward) {
+				return false;
+			}
+		}
+	} else {
+		if(mv.promotion()) {
+			return false;
+		}
+		auto home = c == ChessPieceColor::White ? 1_row : 8_row;
+		if(moved_kind == ChessPieceKind::King and from == make_board_pos('E'_col, home) and row(to) == home and (col(to) == 'G'_col or col(to) == 'C'_col)) {
+			return castle_is_legal(board, state, col(to) == 'G'_col);
+		}
+		if(not piece_attacks(moved_kind, from, board.all_positions())[to]) {
+			return false;
+		}
+	}
+	return leaves_king_safe(board, mv);
+}
+
+// Whether the side to move has any legal move; stops at the first one found.  Castling is
+// never the only legal move (if it's legal, so is the king's step towards the rook), so it
+// isn't tried.
+constexpr bool has_legal_move(const Board& board, const TemporalGameState& state) {
+	auto c = state.active_color;
+	auto own = c == ChessPieceColor::White ? board.white_positions() : board.black_positions();
+	auto occupied = board.all_positions();
+	auto enemy = occupied & ~own;
+	auto try_targets = [&](BoardPos from, BitBoard targets) {
+		for(auto to: targets.positions()) {
+			if(leaves_king_safe(board, PackedMove(from, to))) {
+				return true;
+			}
+		}
+		return false;
+	};
+	for(auto k: {ChessPieceKind::King, ChessPieceKind::Queen, ChessPieceKind::Rook, ChessPieceKind::Bishop, ChessPieceKind::Knight}) {
+		for(auto from: board.positions(c + k).positions()) {
+			if(try_targets(from, piece_attacks(k, from, occupied) & ~own)) {
+				return true;
+			}
+		}
+	}
+	auto captures = enemy;
+	if(state.en_passant_possible) {
+		captures[state.en_passant_target] = true;
+	}
+	auto forward = c == ChessPieceColor::White ? 1 : -1;
+	for(auto from: board.positions(c + ChessPieceKind::Pawn).positions()) {
+		auto targets = pawn_attacks(c, from) & captures;
+		auto r = static_cast<int>(index(row(from))) + forward;
+		if(r >= 0 and r < 8) {
+			auto one = make_board_pos(col(from), row_from_index(static_cast<std::size_t>(r)));
+			if(not occupied[one]) {
+				targets[one] = true;
+				auto start_row = c == ChessPieceColor::White ? 2_row : 7_row;
+				if(row(from) == start_row) {
+					auto two = make_board_pos(col(from), row_from_index(static_cast<std::size_t>(r + forward)));
+					if(not occupied[two]) {
+						targets[two] = true;
+					}
+				}
+			}
+		}
+		if(try_targets(from, targets)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} /* namespace ac */
+
+#endif /* AC_ATTACK_SETS_H */
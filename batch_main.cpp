@@ -0,0 +1,250 @@
+#include "ChessEngine.h"
+#include "GameSnapshot.h"
+#include <boost/filesystem/operations.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+static_assert(__cplusplus >= 201703L, "Compiler must support C++17.");
+
+// Batch analysis of an EPD or FEN file.
+//
+// Every non-empty input line is one position.  Results are appended to the output file as
+// JSON lines tagged with the input line number, in completion order.  The output file is
+// also the checkpoint: rerunning with the same arguments skips every line already present,
+// so an interrupted run picks up where it left off.
+
+static void usage(const char* argv0) {
+	std::cerr << "usage: " << argv0 << " <engine> <positions.epd> <results.jsonl>"
+		" [--engines N] [--depth D] [--movetime MSEC] [--nodes N] [--option NAME=VALUE]...\n";
+}
+
+struct BatchOptions {
+	std::string engine_path;
+	std::string input_path;
+	std::string output_path;
+	std::size_t engine_count = std::max(1u, std::thread::hardware_concurrency() / 2u);
+	ac::UCIGoArgs go_args;
+	std::vector<std::pair<std::string, std::string>> engine_options;
+};
+
+static std::size_t parse_count(const char* s) {
+	char* end = nullptr;
+	auto value = std::strtoull(s, &end, 10);
+	if(end == s or *end != '\0') {
+		throw std::invalid_argument(fmt::format("'{}' is not a number.", s));
+	}
+	return static_cast<std::size_t>(value);
+}
+
+static BatchOptions parse_options(int argc, char** argv) {
+	if(argc < 4) {
+		throw std::invalid_argument("Too few arguments.");
+	}
+	BatchOptions opts;
+	opts.engine_path = argv[1];
+	opts.input_path = argv[2];
+	opts.output_path = argv[3];
+	for(int i = 4; i < argc; ++i) {
+		std::string_view arg(argv[i]);
+		if(i + 1 >= argc) {
+			throw std::invalid_argument(fmt::format("Missing value for '{}'.", arg));
+		}
+		const char* value = argv[++i];
+		if(arg == "--engines") {
+			opts.engine_count = std::max<std::size_t>(1u, parse_count(value));
+		} else if(arg == "--depth") {
+			opts.go_args.depth = parse_count(value);
+		} else if(arg == "--movetime") {
+			opts.go_args.move_time = ac::UCIGoArgs::msec_type(parse_count(value));
+		} else if(arg == "--nodes") {
+			opts.go_args.nodes = parse_count(value);
+		} else if(arg == "--option") {
+			std::string_view opt(value);
+			auto eq = opt.find('=');
+			if(eq == std::string_view::npos) {
+				throw std::invalid_argument(fmt::format("Expected NAME=VALUE, got '{}'.", opt));
+			}
+			opts.engine_options.emplace_back(opt.substr(0u, eq), opt.substr(eq + 1u));
+		} else {
+			throw std::invalid_argument(fmt::format("Unknown argument '{}'.", arg));
+		}
+	}
+	if(not opts.go_args.depth and not opts.go_args.move_time and not opts.go_args.nodes) {
+		throw std::invalid_argument("One of --depth, --movetime or --nodes is required.");
+	}
+	return opts;
+}
+
+// EPD records carry the first four FEN fields followed by opcodes; FEN lines carry all six.
+static std::string position_fields(std::string_view line) {
+	std::string_view fields[6u];
+	std::size_t count = 0u;
+	for(std::string_view rest = line; count < 6u;) {
+		auto start = rest.find_first_not_of(" \t");
+		if(start == std::string_view::npos) {
+			break;
+		}
+		rest.remove_prefix(start);
+		auto stop = std::min(rest.find_first_of(" \t"), rest.size());
+		fields[count++] = rest.substr(0u, stop);
+		rest.remove_prefix(stop);
+	}
+	auto is_number = [](std::string_view sv) {
+		return not sv.empty() and sv.find_first_not_of("0123456789") == std::string_view::npos;
+	};
+	auto used = (count == 6u and is_number(fields[4]) and is_number(fields[5])) ? 6u : std::min<std::size_t>(count, 4u);
+	std::string result;
+	for(std::size_t i = 0u; i < used; ++i) {
+		if(i != 0u) {
+			result += ' ';
+		}
+		result += fields[i];
+	}
+	return result;
+}
+
+// Read back an existing output file, returning the input line numbers it already covers.
+// A partially written trailing record (from a killed run) is cut off so appends stay well-formed.
+static std::unordered_set<std::size_t> load_checkpoint(const std::string& path) {
+	std::unordered_set<std::size_t> done;
+	if(not boost::filesystem::exists(path)) {
+		return done;
+	}
+	std::ifstream in(path, std::ios::binary);
+	std::string line;
+	std::uintmax_t good_size = 0u;
+	while(std::getline(in, line)) {
+		if(in.eof()) {
+			// No trailing newline: the record was cut short.
+			break;
+		}
+		constexpr std::string_view prefix = "{\"line\": ";
+		if(line.compare(0u, prefix.size(), prefix) == 0) {
+			done.insert(static_cast<std::size_t>(std::strtoull(line.c_str() + prefix.size(), nullptr, 10)));
+		}
+		good_size += line.size() + 1u;
+	}
+	in.close();
+	if(good_size != boost::filesystem::file_size(path)) {
+		boost::filesystem::resize_file(path, good_size);
+	}
+	return done;
+}
+
+static std::string format_result(std::size_t line_number, const std::string& fen, const ac::SearchResult& result) {
+	std::string out = fmt::format("{{\"line\": {}, \"fen\": \"{}\"", line_number, fen);
+	if(result.best_move) {
+		out += fmt::format(", \"bestmove\": \"{}\"", ac::long_algebraic_notation(*result.best_move).view());
+	} else {
+		out += ", \"bestmove\": null";
+	}
+	if(result.ponder_move) {
+		out += fmt::format(", \"ponder\": \"{}\"", ac::long_algebraic_notation(*result.ponder_move).view());
+	}
+	out += fmt::format(", \"depth\": {}", result.depth);
+	if(result.score) {
+		auto kind = result.score->kind == ac::uci::ScoreKind::Centipawns ? "cp" : "mate";
+		out += fmt::format(", \"score\": {{\"{}\": {}}}", kind, result.score->value);
+	}
+	out += ", \"pv\": [";
+	for(std::size_t i = 0u; i < result.pv.size(); ++i) {
+		out += fmt::format("{}\"{}\"", i == 0u ? "" : ", ", ac::long_algebraic_notation(result.pv[i]).view());
+	}
+	out += "]}\n";
+	return out;
+}
+
+int main(int argc, char** argv) {
+	BatchOptions opts;
+	try {
+		opts = parse_options(argc, argv);
+	} catch(const std::invalid_argument& e) {
+		std::cerr << e.what() << '\n';
+		usage(argv[0]);
+		return 2;
+	}
+
+	std::ifstream input(opts.input_path);
+	if(not input) {
+		std::cerr << "Failed to open '" << opts.input_path << "'.\n";
+		return 1;
+	}
+	const auto done = load_checkpoint(opts.output_path);
+	std::ofstream output(opts.output_path, std::ios::binary | std::ios::app);
+	if(not output) {
+		std::cerr << "Failed to open '" << opts.output_path << "'.\n";
+		return 1;
+	}
+
+	std::mutex input_mutex;
+	std::size_t line_number = 0u;
+	std::mutex output_mutex;
+	std::atomic<std::size_t> analyzed{0u};
+	std::atomic<bool> failed{false};
+
+	// Positions are pulled one line at a time so the input is never held in memory as a whole.
+	auto next_position = [&]() -> std::optional<std::pair<std::size_t, std::string>> {
+		std::lock_guard<std::mutex> lock(input_mutex);
+		std::string line;
+		while(std::getline(input, line)) {
+			++line_number;
+			if(line.find_first_not_of(" \t\r") == std::string::npos or done.count(line_number) != 0u) {
+				continue;
+			}
+			return std::pair{line_number, position_fields(line)};
+		}
+		return std::nullopt;
+	};
+
+	auto worker = [&]() {
+		try {
+			ac::ChessEngine engine(opts.engine_path.c_str());
+			for(const auto& [name, value]: opts.engine_options) {
+				engine.set_option(name, std::string_view(value));
+			}
+			while(not failed) {
+				auto next = next_position();
+				if(not next) {
+					break;
+				}
+				auto& [number, fen] = *next;
+				ac::GameSnapshot snapshot;
+				try {
+					snapshot = ac::GameSnapshot::decode_fen_string(fen);
+				} catch(const std::runtime_error& e) {
+					std::lock_guard<std::mutex> lock(output_mutex);
+					std::cerr << "line " << number << ": " << e.what() << '\n';
+					continue;
+				}
+				engine.send_command("ucinewgame");
+				engine.set_position(snapshot);
+				auto result = engine.go(opts.go_args);
+				auto record = format_result(number, fen, result);
+				std::lock_guard<std::mutex> lock(output_mutex);
+				output << record << std::flush;
+				++analyzed;
+			}
+		} catch(const std::exception& e) {
+			failed = true;
+			std::lock_guard<std::mutex> lock(output_mutex);
+			std::cerr << "engine failed: " << e.what() << '\n';
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(std::size_t i = 0u; i < opts.engine_count; ++i) {
+		workers.emplace_back(worker);
+	}
+	for(auto& t: workers) {
+		t.join();
+	}
+	std::cerr << "analyzed " << analyzed << " positions (" << done.size() << " already done)\n";
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,434 @@
+#ifndef AC_BATCH_MOVE_COUNTS_H
+#define AC_BATCH_MOVE_COUNTS_H
+
+#include "attack_sets.h"
+#include "BitBoard.h"
+#include "Board.h"
+#include "ChessPiece.h"
+#include "GameSnapshot.h"
+#include "move_generation.h"
+#include "portable-snippets/builtin/builtin.h"
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace ac {
+
+struct MoveCounts {
+	// Legal moves of the side to move.
+	std::uint16_t legal_moves = 0u;
+	// Pseudo-legal moves of the side to move's knights, bishops, rooks and queens, ignoring pins.
+	std::uint16_t mobility    = 0u;
+	bool in_check             = false;
+};
+
+namespace detail {
+
+// Move counting works on several positions at once, one per lane of a "lane vector": either
+// a plain std::uint64_t (one position) or, when built with AVX2, four bitboards in one
+// register.  Everything that doesn't depend on individual squares -- attack maps, pins and
+// the move counts of unpinned pieces -- is computed set-wise on the lanes; only what's left
+// over (pinned pieces, en passant, castling, positions in check) is counted one position at
+// a time.
+
+template <typename V>
+struct LaneTraits;
+
+template <>
+struct LaneTraits<std::uint64_t> {
+	static constexpr std::size_t lanes = 1u;
+
+	static std::uint64_t splat(std::uint64_t bits) {
+		return bits;
+	}
+
+	static std::uint64_t load(const std::uint64_t* bits) {
+		return *bits;
+	}
+
+	static void store(std::uint64_t v, std::uint64_t* bits) {
+		*bits = v;
+	}
+};
+
+constexpr std::uint64_t nonzero(std::uint64_t v) {
+	return v ? ~std::uint64_t(0u) : std::uint64_t(0u);
+}
+
+inline std::uint64_t popcount(std::uint64_t v) {
+	return static_cast<std::uint64_t>(psnip_builtin_popcount64(v));
+}
+
+#ifdef __AVX2__
+
+struct Avx2Lanes {
+	__m256i v;
+};
+
+template <>
+struct LaneTraits<Avx2Lanes> {
+	static constexpr std::size_t lanes = 4u;
+
+	static Avx2Lanes splat(std::uint64_t bits) {
+		return Avx2Lanes{_mm256_set1_epi64x(static_cast<long long>(bits))};
+	}
+
+	static Avx2Lanes load(const std::uint64_t* bits) {
+		return Avx2Lanes{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits))};
+	}
+
+	static void store(Avx2Lanes v, std::uint64_t* bits) {
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(bits), v.v);
+	}
+};
+
+inline Avx2Lanes operator&(Avx2Lanes l, Avx2Lanes r) {
+	return Avx2Lanes{_mm256_and_si256(l.v, r.v)};
+}
+
+inline Avx2Lanes operator|(Avx2Lanes l, Avx2Lanes r) {
+	return Avx2Lanes{_mm256_or_si256(l.v, r.v)};
+}
+
+inline Avx2Lanes operator~(Avx2Lanes v) {
+	return Avx2Lanes{_mm256_xor_si256(v.v, _mm256_set1_epi64x(-1))};
+}
+
+inline Avx2Lanes operator+(Avx2Lanes l, Avx2Lanes r) {
+	return Avx2Lanes{_mm256_add_epi64(l.v, r.v)};
+}
+
+template <int Shift>
+inline Avx2Lanes shifted(Avx2Lanes v) {
+	if constexpr(Shift >= 0) {
+		return Avx2Lanes{_mm256_slli_epi64(v.v, Shift)};
+	} else {
+		return Avx2Lanes{_mm256_srli_epi64(v.v, -Shift)};
+	}
+}
+
+inline Avx2Lanes nonzero(Avx2Lanes v) {
+	return ~Avx2Lanes{_mm256_cmpeq_epi64(v.v, _mm256_setzero_si256())};
+}
+
+// Per-lane population count: look up the bit count of each nibble, then sum each lane's
+// bytes.
+inline Avx2Lanes popcount(Avx2Lanes v) {
+	const auto nibble_counts = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+	);
+	const auto low_nibbles = _mm256_set1_epi8(0x0f);
+	auto lo = _mm256_and_si256(v.v, low_nibbles);
+	auto hi = _mm256_and_si256(_mm256_srli_epi16(v.v, 4), low_nibbles);
+	auto counts = _mm256_add_epi8(_mm256_shuffle_epi8(nibble_counts, lo), _mm256_shuffle_epi8(nibble_counts, hi));
+	return Avx2Lanes{_mm256_sad_epu8(counts, _mm256_setzero_si256())};
+}
+
+using BatchLanes = Avx2Lanes;
+
+#else
+
+using BatchLanes = std::uint64_t;
+
+#endif
+
+template <typename V>
+V select(V mask, V if_set, V if_clear) {
+	return (mask & if_set) | (~mask & if_clear);
+}
+
+inline constexpr std::uint64_t not_first_row = ~first_row_mask;
+inline constexpr std::uint64_t not_first_rows = ~(first_row_mask * 0x03u);
+inline constexpr std::uint64_t not_last_row = ~(first_row_mask << 7u);
+inline constexpr std::uint64_t not_last_rows = ~(first_row_mask * 0xc0u);
+
+// A step across the board as a shift of the bit index, and the squares it may land on
+// without having wrapped from one column into the next.
+template <int Shift, std::uint64_t Mask = ~std::uint64_t(0u)>
+struct Step {
+	template <typename V>
+	static V from(V bits) {
+		return shifted<Shift>(bits) & LaneTraits<V>::splat(Mask);
+	}
+
+	// Squares reached by sliding from each of 'bits' in this direction, up to and including the
+	// first square not in 'empty' (Kogge-Stone fill).
+	template <typename V>
+	static V slide(V bits, V empty) {
+		auto through = empty & LaneTraits<V>::splat(Mask);
+		bits = bits | (through & shifted<Shift>(bits));
+		through = through & shifted<Shift>(through);
+		bits = bits | (through & shifted<2 * Shift>(bits));
+		through = through & shifted<2 * Shift>(through);
+		bits = bits | (through & shifted<4 * Shift>(bits));
+		return from(bits);
+	}
+};
+
+using RookSteps = std::tuple<Step<1, not_first_row>, Step<-1, not_last_row>, Step<8>, Step<-8>>;
+using BishopSteps = std::tuple<Step<9, not_first_row>, Step<-7, not_first_row>, Step<7, not_last_row>, Step<-9, not_last_row>>;
+using KnightSteps = std::tuple<
+	Step<10, not_first_rows>, Step<17, not_first_row>, Step<15, not_last_row>, Step<6, not_last_rows>,
+	Step<-10, not_last_rows>, Step<-17, not_last_row>, Step<-15, not_first_row>, Step<-6, not_first_rows>
+>;
+
+template <typename Steps, typename F>
+void for_each_step(F f) {
+	std::apply([&](auto... steps) { (f(steps), ...); }, Steps());
+}
+
+template <typename V>
+V pawn_captures_west(V pawns, V white) {
+	return select(white, Step<-7, not_first_row>::from(pawns), Step<-9, not_last_row>::from(pawns));
+}
+
+template <typename V>
+V pawn_captures_east(V pawns, V white) {
+	return select(white, Step<9, not_first_row>::from(pawns), Step<7, not_last_row>::from(pawns));
+}
+
+template <typename V>
+struct LaneCounts {
+	// Legal moves of unpinned pieces, leaving out en passant and castling.
+	V legal;
+	// Mobility of unpinned pieces.
+	V mobility;
+	V in_check;
+	V pinned;
+};
+
+// The set-wise part of move counting.  'own' and 'enemy' are the bitboards of the side to
+// move and its opponent indexed by ChessPieceKind, and 'white' is all ones in the lanes where
+// white is to move.
+template <typename V>
+LaneCounts<V> count_lane_moves(const std::array<V, 6u>& own, const std::array<V, 6u>& enemy, V white) {
+	using traits = LaneTraits<V>;
+	auto at = [](const std::array<V, 6u>& pieces, ChessPieceKind k) {
+		return pieces[static_cast<std::size_t>(k)];
+	};
+	auto own_all = own[0] | own[1] | own[2] | own[3] | own[4] | own[5];
+	auto enemy_all = enemy[0] | enemy[1] | enemy[2] | enemy[3] | enemy[4] | enemy[5];
+	auto empty = ~(own_all | enemy_all);
+	auto targets = ~own_all;
+	auto king = at(own, ChessPieceKind::King);
+	auto enemy_orthogonal = at(enemy, ChessPieceKind::Rook) | at(enemy, ChessPieceKind::Queen);
+	auto enemy_diagonal = at(enemy, ChessPieceKind::Bishop) | at(enemy, ChessPieceKind::Queen);
+
+	// Squares the opponent attacks.  Sliders see through the king, so it can't step back
+	// along the line of a check.
+	auto through_king = empty | king;
+	auto attacked = pawn_captures_west(at(enemy, ChessPieceKind::Pawn), ~white)
+		| pawn_captures_east(at(enemy, ChessPieceKind::Pawn), ~white);
+	for_each_step<KnightSteps>([&](auto step) {
+		attacked = attacked | step.from(at(enemy, ChessPieceKind::Knight));
+	});
+	for_each_step<RookSteps>([&](auto step) {
+		attacked = attacked | step.slide(enemy_orthogonal, through_king) | step.from(at(enemy, ChessPieceKind::King));
+	});
+	for_each_step<BishopSteps>([&](auto step) {
+		attacked = attacked | step.slide(enemy_diagonal, through_king) | step.from(at(enemy, ChessPieceKind::King));
+	});
+
+	// A piece is pinned if it's the first one on a line from the king and the next one along
+	// is an enemy slider moving along that line.
+	auto pinned = traits::splat(0u);
+	auto find_pins = [&](auto step, V sliders) {
+		auto first = step.slide(king, empty) & own_all;
+		pinned = pinned | (first & nonzero(step.slide(first, empty) & sliders));
+	};
+	for_each_step<RookSteps>([&](auto step) { find_pins(step, enemy_orthogonal); });
+	for_each_step<BishopSteps>([&](auto step) { find_pins(step, enemy_diagonal); });
+	auto free = ~pinned;
+
+	// Each step or slide direction yields at most one move per destination square, so
+	// counting destinations direction by direction counts moves.
+	auto mobility = traits::splat(0u);
+	auto knights = at(own, ChessPieceKind::Knight) & free;
+	for_each_step<KnightSteps>([&](auto step) {
+		mobility = mobility + popcount(step.from(knights) & targets);
+	});
+	auto orthogonal = (at(own, ChessPieceKind::Rook) | at(own, ChessPieceKind::Queen)) & free;
+	for_each_step<RookSteps>([&](auto step) {
+		mobility = mobility + popcount(step.slide(orthogonal, empty) & targets);
+	});
+	auto diagonal = (at(own, ChessPieceKind::Bishop) | at(own, ChessPieceKind::Queen)) & free;
+	for_each_step<BishopSteps>([&](auto step) {
+		mobility = mobility + popcount(step.slide(diagonal, empty) & targets);
+	});
+
+	auto king_targets = traits::splat(0u);
+	for_each_step<RookSteps>([&](auto step) { king_targets = king_targets | step.from(king); });
+	for_each_step<BishopSteps>([&](auto step) { king_targets = king_targets | step.from(king); });
+	auto legal = mobility + popcount(king_targets & targets & ~attacked);
+
+	// Promotions count once per piece promoted to.
+	auto pawns = at(own, ChessPieceKind::Pawn) & free;
+	auto last = select(white, traits::splat(first_row_mask << 7u), traits::splat(first_row_mask));
+	auto count_pawn_moves = [&](V to) {
+		legal = legal + popcount(to & ~last) + shifted<2>(popcount(to & last));
+	};
+	auto single = select(white, Step<1>::from(pawns), Step<-1>::from(pawns)) & empty;
+	count_pawn_moves(single);
+	auto double_step_row = select(white, traits::splat(first_row_mask << 2u), traits::splat(first_row_mask << 5u));
+	auto twice = select(white, Step<1>::from(single & double_step_row), Step<-1>::from(single & double_step_row)) & empty;
+	count_pawn_moves(twice);
+	count_pawn_moves(pawn_captures_west(pawns, white) & enemy_all);
+	count_pawn_moves(pawn_captures_east(pawns, white) & enemy_all);
+
+	return LaneCounts<V>{legal, mobility, nonzero(king & attacked), pinned};
+}
+
+// Legal moves of the pawn of the side to move on 'from', which is pinned.
+inline std::size_t count_pinned_pawn_moves(const Board& board, const TemporalGameState& state, BoardPos from) {
+	auto c = state.active_color;
+	auto forward = c == ChessPieceColor::White ? 1 : -1;
+	auto last = c == ChessPieceColor::White ? 8_row : 1_row;
+	auto occupied = board.all_positions();
+	auto enemy = occupied & ~(c == ChessPieceColor::White ? board.white_positions() : board.black_positions());
+	std::size_t count = 0u;
+	auto try_move = [&](BoardPos to) {
+		if(leaves_king_safe(board, PackedMove(from, to))) {
+			count += row(to) == last ? 4u : 1u;
+		}
+	};
+	auto r = static_cast<int>(index(row(from))) + forward;
+	auto one = make_board_pos(col(from), row_from_index(static_cast<std::size_t>(r)));
+	if(not occupied[one]) {
+		try_move(one);
+		auto start_row = c == ChessPieceColor::White ? 2_row : 7_row;
+		if(row(from) == start_row) {
+			auto two = make_board_pos(col(from), row_from_index(static_cast<std::size_t>(r + forward)));
+			if(not occupied[two]) {
+				try_move(two);
+			}
+		}
+	}
+	for(auto to: pawn_attacks(c, from).positions()) {
+		if(enemy[to] or (state.en_passant_possible and state.en_passant_target == to)) {
+			try_move(to);
+		}
+	}
+	return count;
+}
+
+// Finish counting one position: everything count_lane_moves() leaves out.
+inline MoveCounts finish_move_counts(
+	const Board& board,
+	const TemporalGameState& state,
+	std::uint64_t legal,
+	std::uint64_t mobility,
+	bool in_check,
+	BitBoard pinned
+) {
+	auto c = state.active_color;
+	auto own = c == ChessPieceColor::White ? board.white_positions() : board.black_positions();
+	auto occupied = board.all_positions();
+	for(auto from: pinned.positions()) {
+		auto k = kind(*board[from]);
+		if(k == ChessPieceKind::Pawn) {
+			legal += count_pinned_pawn_moves(board, state, from);
+			continue;
+		}
+		auto targets = piece_attacks(k, from, occupied) & ~own;
+		mobility += targets.count();
+		for(auto to: targets.positions()) {
+			legal += leaves_king_safe(board, PackedMove(from, to)) ? 1u : 0u;
+		}
+	}
+	if(in_check) {
+		MoveList moves;
+		generate_legal_moves(board, state, moves);
+		legal = moves.size();
+	} else {
+		if(state.en_passant_possible) {
+			auto pawns = board.positions(c + ChessPieceKind::Pawn) & ~pinned;
+			for(auto from: (pawns & pawn_attacks(opposite_color(c), state.en_passant_target)).positions()) {
+				legal += leaves_king_safe(board, PackedMove(from, state.en_passant_target)) ? 1u : 0u;
+			}
+		}
+		legal += castle_is_legal(board, state, true) ? 1u : 0u;
+		legal += castle_is_legal(board, state, false) ? 1u : 0u;
+	}
+	return MoveCounts{static_cast<std::uint16_t>(legal), static_cast<std::uint16_t>(mobility), in_check};
+}
+
+// Count up to one lane vector's worth of positions.
+template <typename V>
+void count_moves_group(const GameSnapshot* snapshots, std::size_t count, MoveCounts* out) {
+	using traits = LaneTraits<V>;
+	constexpr auto lanes = traits::lanes;
+	assert(count <= lanes);
+	std::array<Board, lanes> boards;
+	std::array<std::array<std::uint64_t, lanes>, 6u> own = {};
+	std::array<std::array<std::uint64_t, lanes>, 6u> enemy = {};
+	std::array<std::uint64_t, lanes> white = {};
+	for(std::size_t i = 0u; i < count; ++i) {
+		boards[i] = snapshots[i].board.decompressed();
+		auto c = snapshots[i].temporal_state.active_color;
+		for(std::size_t k = 0u; k < 6u; ++k) {
+			auto piece_kind = static_cast<ChessPieceKind>(k);
+			own[k][i] = boards[i].positions(c + piece_kind).bits();
+			enemy[k][i] = boards[i].positions(opposite_color(c) + piece_kind).bits();
+		}
+		white[i] = c == ChessPieceColor::White ? ~std::uint64_t(0u) : std::uint64_t(0u);
+	}
+	std::array<V, 6u> own_lanes;
+	std::array<V, 6u> enemy_lanes;
+	for(std::size_t k = 0u; k < 6u; ++k) {
+		own_lanes[k] = traits::load(own[k].data());
+		enemy_lanes[k] = traits::load(enemy[k].data());
+	}
+	auto counts = count_lane_moves(own_lanes, enemy_lanes, traits::load(white.data()));
+	std::array<std::uint64_t, lanes> legal;
+	std::array<std::uint64_t, lanes> mobility;
+	std::array<std::uint64_t, lanes> in_check;
+	std::array<std::uint64_t, lanes> pinned;
+	traits::store(counts.legal, legal.data());
+	traits::store(counts.mobility, mobility.data());
+	traits::store(counts.in_check, in_check.data());
+	traits::store(counts.pinned, pinned.data());
+	for(std::size_t i = 0u; i < count; ++i) {
+		out[i] = finish_move_counts(
+			boards[i],
+			snapshots[i].temporal_state,
+			legal[i],
+			mobility[i],
+			in_check[i] != 0u,
+			BitBoard::from_bits(pinned[i])
+		);
+	}
+}
+
+} /* namespace detail */
+
+// Legal move counts, check status and mobility of 'count' positions, written to 'out'.  Built
+// for throughput over large batches (database scans, training data filters): with AVX2
+// enabled (-mavx2, -march=native or the AC_ENABLE_AVX2 CMake option) four positions are
+// counted per pass.
+inline void count_moves(const GameSnapshot* snapshots, std::size_t count, MoveCounts* out) {
+	constexpr auto lanes = detail::LaneTraits<detail::BatchLanes>::lanes;
+	std::size_t i = 0u;
+	for(; i + lanes <= count; i += lanes) {
+		detail::count_moves_group<detail::BatchLanes>(snapshots + i, lanes, out + i);
+	}
+	if(i < count) {
+		detail::count_moves_group<detail::BatchLanes>(snapshots + i, count - i, out + i);
+	}
+}
+
+inline std::vector<MoveCounts> count_moves(const std::vector<GameSnapshot>& snapshots) {
+	std::vector<MoveCounts> counts(snapshots.size());
+	count_moves(snapshots.data(), snapshots.size(), counts.data());
+	return counts;
+}
+
+} /* namespace ac */
+
+#endif /* AC_BATCH_MOVE_COUNTS_H */
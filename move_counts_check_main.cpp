@@ -0,0 +1,139 @@
+#include "batch_move_counts.h"
+#include "attack_sets.h"
+#include "move_generation.h"
+#include "Position.h"
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
+
+static_assert(__cplusplus >= 201703L, "Compiler must support C++17.");
+
+// Check count_moves() against generate_legal_moves() over positions reached by random games
+// from a handful of well-known perft positions (castling, en passant, promotions, pins and
+// checks).  Both the lane-vector path (AVX2 when built with -mavx2) and the one-position
+// path are checked.  As both sides share attack_sets.h, the generator itself is first checked
+// against the published perft node counts of the same positions.  Exits with status 1 on the
+// first mismatch.
+
+namespace {
+
+struct PerftCase {
+	std::string_view fen;
+	std::size_t depth;
+	std::uint64_t nodes;
+};
+
+constexpr PerftCase perft_cases[] = {
+	{ac::standard_starting_fen, 4u, 197281u},
+	{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3u, 97862u},
+	{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 4u, 43238u},
+	{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4u, 422333u},
+	{"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3u, 62379u},
+	{"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 3u, 89890u}
+};
+
+constexpr std::size_t games_per_fen = 40u;
+constexpr std::size_t max_plies     = 120u;
+
+std::uint64_t perft(ac::Position& position, ac::UndoStack& undo, std::size_t depth) {
+	ac::MoveList moves;
+	ac::generate_legal_moves(position.board, position.state, moves);
+	if(depth == 1u) {
+		return moves.size();
+	}
+	std::uint64_t nodes = 0u;
+	for(auto mv: moves) {
+		ac::make_move(position, mv, undo);
+		nodes += perft(position, undo, depth - 1u);
+		ac::unmake_move(position, undo);
+	}
+	return nodes;
+}
+
+ac::MoveCounts expected_counts(const ac::GameSnapshot& snapshot) {
+	auto board = snapshot.board.decompressed();
+	const auto& state = snapshot.temporal_state;
+	auto c = state.active_color;
+	ac::MoveList moves;
+	ac::generate_legal_moves(board, state, moves);
+	auto occupied = board.all_positions();
+	std::size_t mobility = 0u;
+	for(auto k: {ac::ChessPieceKind::Knight, ac::ChessPieceKind::Bishop, ac::ChessPieceKind::Rook, ac::ChessPieceKind::Queen}) {
+		for(auto from: board.positions(c + k).positions()) {
+			mobility += (ac::piece_attacks(k, from, occupied) & ~board.positions(c)).count();
+		}
+	}
+	ac::MoveCounts counts;
+	counts.legal_moves = static_cast<std::uint16_t>(moves.size());
+	counts.mobility = static_cast<std::uint16_t>(mobility);
+	counts.in_check = ac::in_check(board, c);
+	return counts;
+}
+
+bool same_counts(const ac::MoveCounts& l, const ac::MoveCounts& r) {
+	return l.legal_moves == r.legal_moves and l.mobility == r.mobility and l.in_check == r.in_check;
+}
+
+std::vector<ac::GameSnapshot> random_positions() {
+	std::vector<ac::GameSnapshot> positions;
+	std::mt19937_64 rng(0x5eed5eedu);
+	ac::UndoStack undo;
+	for(const auto& perft_case: perft_cases) {
+		auto start = ac::GameSnapshot::decode_fen_string(perft_case.fen);
+		for(std::size_t game = 0u; game < games_per_fen; ++game) {
+			ac::Position position(start);
+			undo.clear();
+			for(std::size_t ply = 0u; ply < max_plies; ++ply) {
+				positions.push_back(position.snapshot());
+				ac::MoveList moves;
+				ac::generate_legal_moves(position.board, position.state, moves);
+				if(moves.empty()) {
+					break;
+				}
+				ac::make_move(position, moves[rng() % moves.size()], undo);
+			}
+		}
+	}
+	// Leave a partial group at the end so the tail of count_moves() is covered too.
+	if(positions.size() % 2u == 0u) {
+		positions.pop_back();
+	}
+	return positions;
+}
+
+} /* namespace */
+
+int main() {
+	ac::UndoStack undo;
+	for(const auto& perft_case: perft_cases) {
+		ac::Position position(ac::GameSnapshot::decode_fen_string(perft_case.fen));
+		undo.clear();
+		auto nodes = perft(position, undo, perft_case.depth);
+		if(nodes != perft_case.nodes) {
+			std::cerr << "perft(" << perft_case.depth << ") of '" << perft_case.fen << "': expected "
+				<< perft_case.nodes << " nodes, generated " << nodes << '\n';
+			return 1;
+		}
+	}
+	auto positions = random_positions();
+	auto batch = ac::count_moves(positions);
+	for(std::size_t i = 0u; i < positions.size(); ++i) {
+		ac::MoveCounts single;
+		ac::detail::count_moves_group<std::uint64_t>(&positions[i], 1u, &single);
+		auto expected = expected_counts(positions[i]);
+		if(not same_counts(batch[i], expected) or not same_counts(single, expected)) {
+			std::cerr << "mismatch in '" << ac::forsyth_edwards_encoding(positions[i]) << "': expected "
+				<< expected.legal_moves << " legal moves, mobility " << expected.mobility
+				<< (expected.in_check ? ", in check" : "") << "; batch counted "
+				<< batch[i].legal_moves << '/' << batch[i].mobility << '/' << batch[i].in_check
+				<< ", single counted "
+				<< single.legal_moves << '/' << single.mobility << '/' << single.in_check << '\n';
+			return 1;
+		}
+	}
+	std::cerr << "checked " << positions.size() << " positions ("
+		<< ac::detail::LaneTraits<ac::detail::BatchLanes>::lanes << " per pass)\n";
+	return 0;
+}
@@ -0,0 +1,237 @@
+#ifndef AC_MOVE_GENERATION_H
+#define AC_MOVE_GENERATION_H
+
+#include "attack_sets.h"
+#include "BitBoard.h"
+#include "Board.h"
+#include "ChessPiece.h"
+#include "GameSnapshot.h"
+#include "Move.h"
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace ac {
+
+// Fixed-capacity list of moves, so generating them never allocates.  No legal position has
+// more than 218 moves.
+struct MoveList {
+	static constexpr std::size_t capacity = 256u;
+
+	constexpr std::size_t size() const {
+		return size_;
+	}
+
+	constexpr bool empty() const {
+		return size_ == 0u;
+	}
+
+	constexpr const PackedMove* begin() const {
+		return moves_.data();
+	}
+
+	constexpr const PackedMove* end() const {
+		return moves_.data() + size_;
+	}
+
+	constexpr PackedMove* begin() {
+		return moves_.data();
+	}
+
+	constexpr PackedMove* end() {
+		return moves_.data() + size_;
+	}
+
+	constexpr PackedMove operator[](std::size_t i) const {
+		assert(i < size_);
+		return moves_[i];
+	}
+
+	constexpr PackedMove& operator[](std::size_t i) {
+		assert(i < size_);
+		return moves_[i];
+	}
+
+	constexpr void push_back(PackedMove mv) {
+		assert(size_ < capacity);
+		moves_[size_++] = mv;
+	}
+
+	constexpr void clear() {
+		size_ = 0u;
+	}
+
+private:
+	std::array<PackedMove, capacity> moves_ = {};
+	std::size_t size_ = 0u;
+};
+
+enum class MoveSelection: unsigned char {
+	All,
+	// Captures (en passant included) and promotions, for quiescence search.
+	Tactical
+};
+
+namespace detail {
+
+// Everything about move generation that depends on the side to move, fixed at compile time.
+template <ChessPieceColor C>
+struct ColorTraits {
+	static constexpr ChessPieceColor them   = opposite_color(C);
+	static constexpr int forward            = C == ChessPieceColor::White ? 1 : -1;
+	static constexpr BoardRow home_row      = C == ChessPieceColor::White ? 1_row : 8_row;
+	// Where a pawn's first step from its starting row lands.
+	static constexpr BoardRow double_step_row = C == ChessPieceColor::White ? 3_row : 6_row;
+	static constexpr BoardRow last_row      = C == ChessPieceColor::White ? 8_row : 1_row;
+	// Bit index offsets of a pawn's step and captures.  Squares are indexed column-major, so
+	// a step is +-1 and a capture +-7 or +-9.  None of these can wrap around the board: a
+	// pawn never stands on its first or last row, and captures off the a- or h-file shift
+	// out of the 64 bits.
+	static constexpr int capture_west       = C == ChessPieceColor::White ? -7 : -9;
+	static constexpr int capture_east       = C == ChessPieceColor::White ?  9 :  7;
+
+	static constexpr BitBoard own(const Board& board) {
+		if constexpr(C == ChessPieceColor::White) {
+			return board.white_positions();
+		} else {
+			return board.black_positions();
+		}
+	}
+};
+
+constexpr void push_pawn_move(MoveList& moves, BoardPos from, BoardPos to, bool promotes) {
+	if(not promotes) {
+		moves.push_back(PackedMove(from, to));
+		return;
+	}
+	for(auto k: {ChessPieceKind::Queen, ChessPieceKind::Rook, ChessPieceKind::Bishop, ChessPieceKind::Knight}) {
+		moves.push_back(PackedMove(from, to, k));
+	}
+}
+
+inline constexpr std::uint64_t first_row_mask = 0x0101010101010101u;
+
+constexpr std::uint64_t row_mask(BoardRow r) {
+	return first_row_mask << index(r);
+}
+
+template <int Shift>
+constexpr std::uint64_t shifted(std::uint64_t bits) {
+	if constexpr(Shift >= 0) {
+		return bits << Shift;
+	} else {
+		return bits >> -Shift;
+	}
+}
+
+// Append a pawn move to each square of 'targets' from the square 'Shift' bits before it.
+template <int Shift>
+constexpr void push_pawn_moves(MoveList& moves, std::uint64_t targets, bool promote) {
+	for(auto to: BitBoard::from_bits(targets).positions()) {
+		auto from = board_pos_from_index(static_cast<std::size_t>(static_cast<int>(index(to)) - Shift));
+		push_pawn_move(moves, from, to, promote);
+	}
+}
+
+// Pawn moves for all of 'C''s pawns at once: each kind of move is a shift of the pawn set
+// masked by where it may land; only the resulting target squares are visited one by one.
+template <ChessPieceColor C>
+constexpr void generate_pawn_moves(const Board& board, const TemporalGameState& state, BitBoard occupied, BitBoard enemy, bool quiet, MoveList& moves) {
+	using traits = ColorTraits<C>;
+	constexpr auto last = row_mask(traits::last_row);
+	auto pawns = board.positions(C + ChessPieceKind::Pawn).bits();
+	auto empty = ~occupied.bits();
+	auto single = shifted<traits::forward>(pawns) & empty;
+	push_pawn_moves<traits::forward>(moves, single & last, true);
+	if(quiet) {
+		push_pawn_moves<traits::forward>(moves, single & ~last, false);
+		auto twice = shifted<traits::forward>(single & row_mask(traits::double_step_row)) & empty;
+		push_pawn_moves<2 * traits::forward>(moves, twice, false);
+	}
+	auto west = shifted<traits::capture_west>(pawns);
+	auto east = shifted<traits::capture_east>(pawns);
+	auto captures = enemy.bits();
+	push_pawn_moves<traits::capture_west>(moves, west & captures & last, true);
+	push_pawn_moves<traits::capture_west>(moves, west & captures & ~last, false);
+	push_pawn_moves<traits::capture_east>(moves, east & captures & last, true);
+	push_pawn_moves<traits::capture_east>(moves, east & captures & ~last, false);
+	if(state.en_passant_possible) {
+		auto target = std::uint64_t(1u) << index(state.en_passant_target);
+		push_pawn_moves<traits::capture_west>(moves, west & target, false);
+		push_pawn_moves<traits::capture_east>(moves, east & target, false);
+	}
+}
+
+// Castling for 'C' on the given side, if castle_is_legal().
+template <ChessPieceColor C, bool Kingside>
+constexpr void generate_castle(const Board& board, const TemporalGameState& state, BitBoard occupied, MoveList& moves) {
+	using traits = ColorTraits<C>;
+	if(castle_is_legal<C, Kingside>(board, state, occupied)) {
+		moves.push_back(PackedMove(
+			make_board_pos('E'_col, traits::home_row),
+			make_board_pos(Kingside ? 'G'_col : 'C'_col, traits::home_row)
+		));
+	}
+}
+
+template <ChessPieceColor C>
+constexpr void generate_pseudo_legal_moves(const Board& board, const TemporalGameState& state, MoveList& moves, MoveSelection selection) {
+	using traits = ColorTraits<C>;
+	auto own = traits::own(board);
+	auto occupied = board.all_positions();
+	auto enemy = occupied & ~own;
+	auto quiet = selection == MoveSelection::All;
+	auto targets = quiet ? ~own : enemy;
+	for(auto k: {ChessPieceKind::Knight, ChessPieceKind::Bishop, ChessPieceKind::Rook, ChessPieceKind::Queen, ChessPieceKind::King}) {
+		for(auto from: board.positions(C + k).positions()) {
+			for(auto to: (piece_attacks(k, from, occupied) & targets).positions()) {
+				moves.push_back(PackedMove(from, to));
+			}
+		}
+	}
+	generate_pawn_moves<C>(board, state, occupied, enemy, quiet, moves);
+	if(quiet) {
+		generate_castle<C, true>(board, state, occupied, moves);
+		generate_castle<C, false>(board, state, occupied, moves);
+	}
+}
+
+} /* namespace detail */
+
+// Append the moves of the side to move that follow the pieces' movement rules, without
+// checking whether they leave the mover's king in check.  Castling is only generated when
+// it is fully legal (see castle_is_legal()).  The side to move is dispatched on once; the
+// generators themselves are specialized per color.
+constexpr void generate_pseudo_legal_moves(
+	const Board& board,
+	const TemporalGameState& state,
+	MoveList& moves,
+	MoveSelection selection = MoveSelection::All
+) {
+	if(state.active_color == ChessPieceColor::White) {
+		detail::generate_pseudo_legal_moves<ChessPieceColor::White>(board, state, moves, selection);
+	} else {
+		detail::generate_pseudo_legal_moves<ChessPieceColor::Black>(board, state, moves, selection);
+	}
+}
+
+// Append the legal moves of the side to move.
+constexpr void generate_legal_moves(
+	const Board& board,
+	const TemporalGameState& state,
+	MoveList& moves,
+	MoveSelection selection = MoveSelection::All
+) {
+	MoveList pseudo_legal;
+	generate_pseudo_legal_moves(board, state, pseudo_legal, selection);
+	for(auto mv: pseudo_legal) {
+		if(leaves_king_safe(board, mv)) {
+			moves.push_back(mv);
+		}
+	}
+}
+
+} /* namespace ac */
+
+#endif /* AC_MOVE_GENERATION_H */
@@ -0,0 +1,42 @@
+#include "PGNImporter.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static_assert(__cplusplus >= 201703L, "Compiler must support C++17.");
+
+// Convert a PGN file into a game archive (see GameArchive.h).  Games that fail to parse are
+// reported on stderr and left out.
+
+static void usage(const char* argv0) {
+	std::cerr << "usage: " << argv0 << " <games.pgn> <games.archive> [--threads N]\n";
+}
+
+int main(int argc, char** argv) {
+	if(argc != 3 and argc != 5) {
+		usage(argv[0]);
+		return 2;
+	}
+	ac::PGNImportOptions options;
+	if(argc == 5) {
+		char* end = nullptr;
+		auto count = std::strtoull(argv[4], &end, 10);
+		if(std::string_view(argv[3]) != "--threads" or end == argv[4] or *end != '\0') {
+			usage(argv[0]);
+			return 2;
+		}
+		options.thread_count = std::max<std::size_t>(1u, count);
+	}
+	try {
+		ac::GameArchiveWriter archive(argv[2]);
+		auto stats = ac::import_pgn(argv[1], archive, options, [](std::size_t offset, const std::string& what) {
+			std::cerr << "game at byte " << offset << ": " << what << '\n';
+		});
+		archive.finish();
+		std::cerr << "imported " << stats.games_imported << " games (" << stats.games_skipped << " skipped)\n";
+	} catch(const std::exception& e) {
+		std::cerr << "import failed: " << e.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
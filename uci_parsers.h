@@ -107,6 +107,69 @@ inline const auto uci_option_parser
 inline const auto uci_id_name_parser = x3::lit("id") > "name" > multiword_string_before(x3::eoi);
 inline const auto uci_id_author_parser = x3::lit("id") > "author" > multiword_string_before(x3::eoi);
 
+inline const auto uci_move_parser
+	= x3::rule<struct uci_move_tag, PackedMove>()
+	= x3::lexeme[
+		x3::raw[
+			x3::char_("a-h") >> x3::char_("1-8")
+			>> x3::char_("a-h") >> x3::char_("1-8")
+			>> -x3::char_("nbrq")
+		] >> !x3::graph
+	][([](auto& ctx) {
+		// Decoded in place from the input; no string is built per move.
+		const auto& range = x3::_attr(ctx);
+		auto mv = decode_long_algebraic_notation(std::string_view(&*range.begin(), static_cast<std::size_t>(range.size())));
+		if(mv) {
+			x3::_val(ctx) = *mv;
+		} else {
+			x3::_pass(ctx) = false;
+		}
+	})];
+
+inline const auto uci_score_parser
+	= x3::rule<struct uci_score_tag, Score>()
+	= (x3::lit("cp") >> x3::int32[([](auto& ctx) {
+		x3::_val(ctx) = Score{ScoreKind::Centipawns, x3::_attr(ctx)};
+	})])
+	| (x3::lit("mate") >> x3::int32[([](auto& ctx) {
+		x3::_val(ctx) = Score{ScoreKind::Mate, x3::_attr(ctx)};
+	})]);
+
+template <ScoreBound Bound>
+inline constexpr auto assign_bound = [](auto& ctx) {
+	x3::_val(ctx).bound = Bound;
+};
+
+inline constexpr auto push_back_pv = [](auto& ctx) {
+	x3::_val(ctx).pv.push_back(x3::_attr(ctx));
+};
+
+inline const auto uci_info_parser
+	= x3::rule<struct uci_info_tag, InfoLine>()
+	= x3::lit("info") >> *(
+		(x3::lit("depth") >> x3::ulong_[assign_member<&InfoLine::depth>])
+		| (x3::lit("seldepth") >> x3::ulong_[assign_member<&InfoLine::seldepth>])
+		| (x3::lit("multipv") >> x3::ulong_[assign_member<&InfoLine::multipv>])
+		| (x3::lit("score") >> uci_score_parser[assign_member<&InfoLine::score>] >> -(
+			x3::lit("lowerbound")[assign_bound<ScoreBound::Lower>]
+			| x3::lit("upperbound")[assign_bound<ScoreBound::Upper>]
+		))
+		| (x3::lit("nodes") >> x3::ulong_long[assign_member<&InfoLine::nodes>])
+		| (x3::lit("nps") >> x3::ulong_long[assign_member<&InfoLine::nps>])
+		| (x3::lit("time") >> x3::ulong_long[assign_member<&InfoLine::time_msec>])
+		| (x3::lit("pv") >> +uci_move_parser[push_back_pv])
+		// 'string' swallows the rest of the line.
+		| (x3::lit("string") >> x3::omit[x3::lexeme[*x3::char_]])
+		| x3::omit[x3::lexeme[+x3::graph]]
+	);
+
+inline const auto uci_bestmove_parser
+	= x3::rule<struct uci_bestmove_tag, BestMove>()
+	= x3::lit("bestmove") >> (
+		uci_move_parser[assign_member<&BestMove::move>]
+		| x3::lit("(none)")
+	) >> -(x3::lit("ponder") >> uci_move_parser[assign_member<&BestMove::ponder>]);
+
 
 } /* namespace ac::uci */
 